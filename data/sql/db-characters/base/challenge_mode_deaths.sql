@@ -0,0 +1,9 @@
+CREATE TABLE IF NOT EXISTS `challenge_mode_deaths` (
+  `id` INT UNSIGNED NOT NULL AUTO_INCREMENT,
+  `guid` INT UNSIGNED NOT NULL,
+  `level` TINYINT UNSIGNED NOT NULL DEFAULT 0,
+  `died` TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`id`),
+  KEY `idx_died` (`died`),
+  KEY `idx_guid` (`guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COMMENT='mod-challenge-modes hardcore deaths';
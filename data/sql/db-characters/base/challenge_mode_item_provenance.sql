@@ -0,0 +1,7 @@
+CREATE TABLE IF NOT EXISTS `challenge_mode_item_provenance` (
+  `item_guid` INT UNSIGNED NOT NULL,
+  `owner_guid` INT UNSIGNED NOT NULL,
+  `provenance` TINYINT UNSIGNED NOT NULL DEFAULT 0 COMMENT '1 = traded, 2 = mailed, 3 = bought at the auction house',
+  PRIMARY KEY (`item_guid`),
+  KEY `idx_owner` (`owner_guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COMMENT='mod-challenge-modes item provenance';
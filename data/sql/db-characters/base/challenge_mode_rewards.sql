@@ -0,0 +1,13 @@
+CREATE TABLE IF NOT EXISTS `challenge_mode_rewards` (
+  `guid` INT UNSIGNED NOT NULL,
+  `mode` TINYINT UNSIGNED NOT NULL,
+  `level` TINYINT UNSIGNED NOT NULL,
+  `reward_type` TINYINT UNSIGNED NOT NULL COMMENT '0 = title, 1 = talent points, 2 = item, 3 = achievement',
+  `reward_id` INT UNSIGNED NOT NULL DEFAULT 0,
+  `amount` INT UNSIGNED NOT NULL DEFAULT 0,
+  `state` TINYINT UNSIGNED NOT NULL DEFAULT 0 COMMENT '0 = pending, 1 = delivered, 2 = invalid',
+  `created` TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  `delivered` TIMESTAMP NULL DEFAULT NULL,
+  PRIMARY KEY (`guid`, `mode`, `level`, `reward_type`),
+  KEY `idx_state_guid` (`state`, `guid`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COMMENT='mod-challenge-modes reward ledger';
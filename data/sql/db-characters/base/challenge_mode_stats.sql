@@ -0,0 +1,11 @@
+CREATE TABLE IF NOT EXISTS `challenge_mode_stats` (
+  `id` INT UNSIGNED NOT NULL AUTO_INCREMENT,
+  `time` INT UNSIGNED NOT NULL COMMENT 'unix time at the end of the aggregation period',
+  `mode` TINYINT UNSIGNED NOT NULL,
+  `stat` TINYINT UNSIGNED NOT NULL COMMENT '0 = deaths, 1 = level ups, 2 = median played seconds at level up, 3 = rewards, 4 = equips denied, 5 = item uses denied, 6 = level ups in a played time bucket',
+  `key` TINYINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'level bracket for deaths, level for level ups and played time buckets, reward type for rewards',
+  `bucket` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'first played second of the played time bucket',
+  `value` INT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (`id`),
+  KEY `idx_time` (`time`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COMMENT='mod-challenge-modes gameplay telemetry';
@@ -3,6 +3,62 @@
  */
 
 #include "ChallengeModes.h"
+#include "ChallengeModesBulk.h"
+#include "ChallengeModesDeaths.h"
+#include "ChallengeModesJournal.h"
+#include "ChallengeModesLeaderboard.h"
+#include "ChallengeModesProvenance.h"
+#include "ChallengeModesRewards.h"
+#include "ChallengeModesSpeedrun.h"
+#include "ChallengeModesStats.h"
+#include <algorithm>
+
+constexpr bool challengeModesConflict(ChallengeModeSettings first, ChallengeModeSettings second)
+{
+    return !challengeModeAllowed(first, challengeModeMask(second));
+}
+
+// Checks every pair of modes: a mode always conflicts with itself and conflicts are symmetric
+constexpr bool challengeModeConflictsConsistent()
+{
+    for (ChallengeModeSettings first : challengeModeList)
+    {
+        if (!challengeModesConflict(first, first))
+        {
+            return false;
+        }
+        for (ChallengeModeSettings second : challengeModeList)
+        {
+            if (challengeModesConflict(first, second) != challengeModesConflict(second, first))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+constexpr uint32 challengeModeConflictingPairs()
+{
+    uint32 pairs = 0;
+    for (ChallengeModeSettings first : challengeModeList)
+    {
+        for (ChallengeModeSettings second : challengeModeList)
+        {
+            if (first < second && challengeModesConflict(first, second))
+            {
+                ++pairs;
+            }
+        }
+    }
+    return pairs;
+}
+
+static_assert(challengeModeConflictsConsistent(), "Challenge mode conflicts must be symmetric and include the mode itself");
+static_assert(challengeModesConflict(SETTING_HARDCORE, SETTING_SEMI_HARDCORE), "Hardcore and Semi-Hardcore are exclusive");
+static_assert(challengeModesConflict(SETTING_SELF_CRAFTED, SETTING_IRON_MAN), "Self Crafted and Iron Man are exclusive");
+static_assert(challengeModesConflict(SETTING_SLOW_XP_GAIN, SETTING_VERY_SLOW_XP_GAIN), "Slow and Very Slow XP Gain are exclusive");
+static_assert(challengeModeConflictingPairs() == 3, "Every other pair of challenge modes can be combined");
 
 ChallengeModes* ChallengeModes::instance()
 {
@@ -16,7 +72,113 @@ bool ChallengeModes::challengeEnabledForPlayer(ChallengeModeSettings setting, Pl
     {
         return false;
     }
-    return player->GetPlayerSetting("mod-challenge-modes", setting).value;
+    return getPlayerSettings(player).IsSet(setting);
+}
+
+static ChallengeModePlayerSettings readPlayerSettings(Player* player)
+{
+    ChallengeModePlayerSettings settings;
+    for (uint8 i = 0; i < MAX_CHALLENGE_MODE_SETTING; ++i)
+    {
+        settings.Set(i, player->GetPlayerSetting(challengeModeSettingSource, i).value);
+    }
+    return settings;
+}
+
+ChallengeModePlayerData* ChallengeModes::getPlayerData(Player* player)
+{
+    return player->CustomData.Get<ChallengeModePlayerData>(challengeModeSettingSource);
+}
+
+ChallengeModePlayerSettings ChallengeModes::getPlayerSettings(Player* player)
+{
+    if (ChallengeModePlayerData const* data = getPlayerData(player))
+    {
+        return *data;
+    }
+    // Hooks that run while the character is still loading read the settings from the player
+    return readPlayerSettings(player);
+}
+
+void ChallengeModes::loadPlayerSettings(Player* player)
+{
+    ChallengeModePlayerSettings& settings = *player->CustomData.GetDefault<ChallengeModePlayerData>(challengeModeSettingSource);
+    settings = readPlayerSettings(player);
+}
+
+void ChallengeModes::setPlayerSetting(Player* player, uint8 settingIndex, uint32 value)
+{
+    player->UpdatePlayerSetting(challengeModeSettingSource, settingIndex, value);
+    if (ChallengeModePlayerData* data = getPlayerData(player))
+    {
+        data->Set(settingIndex, value);
+    }
+}
+
+uint32 ChallengeModes::getGearValidationStamp(Player* player) const
+{
+    uint32 mask = 0;
+    for (ChallengeModeSettings setting : { SETTING_SELF_CRAFTED, SETTING_ITEM_QUALITY_LEVEL, SETTING_IRON_MAN })
+    {
+        if (challengeEnabledForPlayer(setting, player))
+        {
+            mask |= challengeModeMask(setting);
+        }
+    }
+    if (!mask)
+    {
+        return 0;
+    }
+    return (GEAR_RULES_VERSION << 16) | (provenanceEnable && (mask & provenanceChallengeMask) ? GEAR_RULES_PROVENANCE : 0) | mask;
+}
+
+// Equip checks while a character loads run consecutively on the loading thread, so the stamp comparison is cached per thread
+static thread_local ObjectGuid::LowType loginGearGuid = 0;
+static thread_local bool loginGearValidated = false;
+
+bool ChallengeModes::gearValidatedForLogin(Player* player, bool notLoading) const
+{
+    if (notLoading)
+    {
+        return false;
+    }
+    ObjectGuid::LowType guid = player->GetGUID().GetCounter();
+    if (loginGearGuid != guid)
+    {
+        loginGearGuid = guid;
+        loginGearValidated = getPlayerSettings(player).Get(GEAR_VALIDATED_STAMP) == getGearValidationStamp(player);
+    }
+    return loginGearValidated;
+}
+
+void ChallengeModes::resetGearValidationCache()
+{
+    loginGearGuid = 0;
+    loginGearValidated = false;
+}
+
+// The resurrect hooks run inside ResurrectPlayer, so the revived character only has to be remembered for the call
+static thread_local Player* gmRevivedPlayer = nullptr;
+
+void ChallengeModes::reviveHardcorePlayer(Player* player)
+{
+    setPlayerSetting(player, HARDCORE_DEAD, 0);
+    sChallengeModeDeaths->CancelDeath(player->GetGUID().GetCounter());
+    sChallengeModeLeaderboard->UpdatePlayer(player);
+    if (player->IsAlive())
+    {
+        return;
+    }
+    gmRevivedPlayer = player;
+    player->ResurrectPlayer(1.0f);
+    gmRevivedPlayer = nullptr;
+    player->SpawnCorpseBones();
+    player->SaveToDB(false, false);
+}
+
+bool ChallengeModes::isGmRevive(Player* player)
+{
+    return player == gmRevivedPlayer;
 }
 
 bool ChallengeModes::challengeEnabled(ChallengeModeSettings setting) const
@@ -39,7 +201,11 @@ bool ChallengeModes::challengeEnabled(ChallengeModeSettings setting) const
             return questXpOnlyEnable;
         case SETTING_IRON_MAN:
             return ironManEnable;
+        case SETTING_SPEEDRUN:
+            return speedrunEnable;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return false;
@@ -65,7 +231,11 @@ uint32 ChallengeModes::getDisableLevel(ChallengeModeSettings setting) const
             return questXpOnlyDisableLevel;
         case SETTING_IRON_MAN:
             return ironManDisableLevel;
+        case SETTING_SPEEDRUN:
+            return speedrunDisableLevel;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return 0;
@@ -91,7 +261,11 @@ float ChallengeModes::getXpBonusForChallenge(ChallengeModeSettings setting) cons
             return questXpOnlyXpBonus;
         case SETTING_IRON_MAN:
             return ironManXpBonus;
+        case SETTING_SPEEDRUN:
+            return speedrunXpBonus;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return 1;
@@ -117,7 +291,11 @@ const std::unordered_map<uint8, uint32> *ChallengeModes::getTitleMapForChallenge
             return &questXpOnlyTitleRewards;
         case SETTING_IRON_MAN:
             return &ironManTitleRewards;
+        case SETTING_SPEEDRUN:
+            return &speedrunTitleRewards;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return {};
@@ -143,7 +321,11 @@ const std::unordered_map<uint8, uint32> *ChallengeModes::getTalentMapForChalleng
             return &questXpOnlyTalentRewards;
         case SETTING_IRON_MAN:
             return &ironManTalentRewards;
+        case SETTING_SPEEDRUN:
+            return &speedrunTalentRewards;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return {};
@@ -169,7 +351,11 @@ const std::unordered_map<uint8, uint32> *ChallengeModes::getItemMapForChallenge(
             return &questXpOnlyItemRewards;
         case SETTING_IRON_MAN:
             return &ironManItemRewards;
+        case SETTING_SPEEDRUN:
+            return &speedrunItemRewards;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return {};
@@ -195,7 +381,11 @@ uint32 ChallengeModes::getItemRewardAmount(ChallengeModeSettings setting) const
             return questXpOnlyItemRewardAmount;
         case SETTING_IRON_MAN:
             return ironManItemRewardAmount;
+        case SETTING_SPEEDRUN:
+            return speedrunItemRewardAmount;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return 0;
@@ -221,12 +411,113 @@ const std::unordered_map<uint8, uint32> *ChallengeModes::getAchievementMapForCha
             return &questXpOnlyAchievementReward;
         case SETTING_IRON_MAN:
             return &ironManAchievementReward;
+        case SETTING_SPEEDRUN:
+            return &speedrunAchievementReward;
         case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
             break;
     }
     return {};
 }
 
+char const* ChallengeModes::getChallengeName(ChallengeModeSettings setting)
+{
+    switch (setting)
+    {
+        case SETTING_HARDCORE:
+            return "Hardcore";
+        case SETTING_SEMI_HARDCORE:
+            return "SemiHardcore";
+        case SETTING_SELF_CRAFTED:
+            return "SelfCrafted";
+        case SETTING_ITEM_QUALITY_LEVEL:
+            return "ItemQualityLevel";
+        case SETTING_SLOW_XP_GAIN:
+            return "SlowXpGain";
+        case SETTING_VERY_SLOW_XP_GAIN:
+            return "VerySlowXpGain";
+        case SETTING_QUEST_XP_ONLY:
+            return "QuestXpOnly";
+        case SETTING_IRON_MAN:
+            return "IronMan";
+        case SETTING_SPEEDRUN:
+            return "Speedrun";
+        case HARDCORE_DEAD:
+        case GEAR_VALIDATED_STAMP:
+        case HARDCORE_REVIVED:
+            break;
+    }
+    return "";
+}
+
+bool ChallengeModes::getChallengeByName(std::string_view name, ChallengeModeSettings& setting)
+{
+    for (ChallengeModeSettings challenge : challengeModeList)
+    {
+        if (StringEqualI(name, getChallengeName(challenge)))
+        {
+            setting = challenge;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ChallengeModes::settingEnabledInData(std::string_view data, uint8 settingIndex)
+{
+    // Player settings are stored in character_settings as space separated values, one per setting index
+    uint8 index = 0;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t end = data.find(' ', pos);
+        if (end == std::string_view::npos)
+        {
+            end = data.size();
+        }
+        if (index == settingIndex)
+        {
+            std::string_view value = data.substr(pos, end - pos);
+            return !value.empty() && value != "0";
+        }
+        ++index;
+        pos = end + 1;
+    }
+    return false;
+}
+
+std::string ChallengeModes::getLogsPath(std::string const& fileName)
+{
+    std::string logsDir = sConfigMgr->GetOption<std::string>("LogsDir", "");
+    if (!logsDir.empty() && logsDir.back() != '/' && logsDir.back() != '\\')
+    {
+        logsDir.push_back('/');
+    }
+    return logsDir + fileName;
+}
+
+// Player settings are stored in character_settings.data as space separated values
+std::string ChallengeModes::settingValueSql(uint8 settingIndex)
+{
+    return Acore::StringFormat("SUBSTRING_INDEX(SUBSTRING_INDEX(s.data, ' ', {}), ' ', -1)", settingIndex + 1);
+}
+
+std::string ChallengeModes::settingEnabledSql(uint8 settingIndex)
+{
+    // The core writes the data with a trailing space, so settings that were never set come out as an empty token
+    return Acore::StringFormat("(CHAR_LENGTH(s.data) - CHAR_LENGTH(REPLACE(s.data, ' ', '')) >= {} AND {} NOT IN ('', '0'))", settingIndex, settingValueSql(settingIndex));
+}
+
+std::string ChallengeModes::setSettingSql(uint8 settingIndex, uint32 value, std::string const& data)
+{
+    // Rows saved before the setting was first set are shorter, they are padded with zeros so the value lands on its own token
+    std::string padded = Acore::StringFormat("TRIM(CONCAT(TRIM({0}), REPEAT(' 0', GREATEST(0, CAST({1} AS SIGNED) - (TRIM({0}) <> '') - CHAR_LENGTH(TRIM({0})) + CHAR_LENGTH(REPLACE(TRIM({0}), ' ', ''))))))",
+        data, settingIndex + 1);
+    return Acore::StringFormat("CONCAT_WS(' ', NULLIF(SUBSTRING_INDEX({}, ' ', {}), ''), '{}', NULLIF(SUBSTRING({}, CHAR_LENGTH(SUBSTRING_INDEX({}, ' ', {})) + 2), ''))",
+        padded, settingIndex, value, padded, padded, settingIndex + 1);
+}
+
 class ChallengeModes_WorldScript : public WorldScript
 {
 public:
@@ -239,6 +530,59 @@ public:
         LoadConfig();
     }
 
+    void OnStartup() override
+    {
+        if (!sChallengeModes->enabled())
+        {
+            return;
+        }
+        if (sChallengeModes->journalEnable)
+        {
+            sChallengeModeJournal->Open(ChallengeModes::getLogsPath(sChallengeModes->journalFile), sChallengeModes->journalCapacity);
+        }
+        if (sChallengeModes->provenanceEnable)
+        {
+            sChallengeModeProvenance->DeleteOrphans();
+        }
+        if (sChallengeModes->leaderboardEnable)
+        {
+            sChallengeModeLeaderboard->Start();
+        }
+    }
+
+    void OnShutdown() override
+    {
+        if (sChallengeModes->enabled() && sChallengeModes->statsEnable)
+        {
+            sChallengeModeStats->Flush(true);
+        }
+        sChallengeModeDeaths->Flush();
+        sChallengeModeJournal->Close();
+        sChallengeModeLeaderboard->Stop();
+    }
+
+    void OnUpdate(uint32 diff) override
+    {
+        // The bulk commands also work while the challenges are disabled
+        sChallengeModeBulk->Update();
+        if (!sChallengeModes->enabled())
+        {
+            return;
+        }
+        sChallengeModeRewards->Update(diff);
+        sChallengeModeDeaths->Update();
+        sChallengeModeProvenance->Update();
+        sChallengeModeLeaderboard->Update();
+        if (sChallengeModes->challengeEnabled(SETTING_SPEEDRUN))
+        {
+            sChallengeModeSpeedrun->Update(diff);
+        }
+        if (sChallengeModes->statsEnable)
+        {
+            sChallengeModeStats->Update(diff);
+        }
+    }
+
 private:
     static void LoadStringToMap(std::unordered_map<uint8, uint32> &mapToLoad, const std::string &configString)
     {
@@ -258,6 +602,166 @@ private:
         }
     }
 
+    static bool GetXpSourceByName(std::string const& name, uint8& xpSource)
+    {
+        if (StringEqualI(name, "kill"))
+            xpSource = XPSOURCE_KILL;
+        else if (StringEqualI(name, "quest"))
+            xpSource = XPSOURCE_QUEST;
+        else if (StringEqualI(name, "dungeonfinder"))
+            xpSource = XPSOURCE_QUEST_DF;
+        else if (StringEqualI(name, "explore"))
+            xpSource = XPSOURCE_EXPLORE;
+        else if (StringEqualI(name, "battleground"))
+            xpSource = XPSOURCE_BATTLEGROUND;
+        else
+            return false;
+        return true;
+    }
+
+    static void LoadXpMultiplierTable(ChallengeModeSettings setting, const std::string &configString)
+    {
+        struct CurvePoint
+        {
+            uint8 level;
+            float multiplier;
+            int8 xpSource; // -1 applies to every XP source
+        };
+        std::vector<CurvePoint> curve;
+
+        std::string delimitedValue;
+        std::stringstream configIdStream;
+
+        configIdStream.str(configString);
+        // Process each curve point in the string, delimited by the comma - "," and then space " "
+        while (std::getline(configIdStream, delimitedValue, ','))
+        {
+            std::string levelStr, multiplierStr, sourceStr;
+            std::stringstream configPointStream(delimitedValue);
+            configPointStream>>levelStr>>multiplierStr>>sourceStr;
+            if (levelStr.empty())
+            {
+                continue;
+            }
+            CurvePoint point{ uint8(atoi(levelStr.c_str())), float(atof(multiplierStr.c_str())), -1 };
+            if (!sourceStr.empty())
+            {
+                uint8 xpSource;
+                if (!GetXpSourceByName(sourceStr, xpSource))
+                {
+                    LOG_ERROR("mod-challenge-modes", "Invalid XP source {} in {}.XPMultiplierCurve!", sourceStr, ChallengeModes::getChallengeName(setting));
+                    continue;
+                }
+                point.xpSource = xpSource;
+            }
+            curve.push_back(point);
+        }
+
+        float baseMultiplier = sChallengeModes->getXpBonusForChallenge(setting);
+        ChallengeXpMultiplierTable& table = sChallengeModes->xpMultiplierTables[setting];
+        for (uint8 xpSource = 0; xpSource < MAX_CHALLENGE_XP_SOURCE; ++xpSource)
+        {
+            // Points for a specific XP source replace the generic points for that source
+            bool hasSourcePoints = std::any_of(curve.begin(), curve.end(), [xpSource](CurvePoint const& point) { return point.xpSource == xpSource; });
+            int8 curveSource = hasSourcePoints ? int8(xpSource) : int8(-1);
+
+            for (uint32 level = 0; level < table.size(); ++level)
+            {
+                // The multiplier of the highest point at or below the level applies
+                float multiplier = 1.0f;
+                int32 pointLevel = -1;
+                for (CurvePoint const& point : curve)
+                {
+                    if (point.xpSource == curveSource && point.level <= level && int32(point.level) > pointLevel)
+                    {
+                        multiplier = point.multiplier;
+                        pointLevel = point.level;
+                    }
+                }
+                table[level][xpSource] = uint32(baseMultiplier * multiplier * XP_MULTIPLIER_ONE + 0.5f);
+            }
+        }
+    }
+
+    static ChallengeMapSet LoadStringToMapSet(ChallengeModeSettings setting, const std::string &configName)
+    {
+        ChallengeMapSet maps;
+        std::string delimitedValue;
+        std::stringstream configIdStream;
+
+        configIdStream.str(sConfigMgr->GetOption<std::string>(std::string(ChallengeModes::getChallengeName(setting)) + configName, ""));
+        // Process each map ID in the string, delimited by the comma - ","
+        while (std::getline(configIdStream, delimitedValue, ','))
+        {
+            if (delimitedValue.find_first_not_of(' ') == std::string::npos)
+            {
+                continue;
+            }
+            uint32 mapId = atoi(delimitedValue.c_str());
+            if (mapId >= MAX_CHALLENGE_MAP_ID)
+            {
+                LOG_ERROR("mod-challenge-modes", "Invalid map ID {} in {}{}!", mapId, ChallengeModes::getChallengeName(setting), configName);
+                continue;
+            }
+            maps.set(mapId);
+        }
+        return maps;
+    }
+
+    static void LoadRewardLevels()
+    {
+        for (ChallengeModeSettings setting : challengeModeList)
+        {
+            std::bitset<256>& levels = sChallengeModes->rewardLevels[setting];
+            levels.reset();
+            for (auto const* rewardMap : { sChallengeModes->getTitleMapForChallenge(setting), sChallengeModes->getTalentMapForChallenge(setting),
+                sChallengeModes->getItemMapForChallenge(setting), sChallengeModes->getAchievementMapForChallenge(setting) })
+            {
+                for (auto const& [level, reward] : *rewardMap)
+                {
+                    levels.set(level);
+                }
+            }
+        }
+    }
+
+    static void LoadMapRestrictions()
+    {
+        ChallengeMapSet deniedMaps[MAX_CHALLENGE_MODE_SETTING];
+        sChallengeModes->dungeonFinderDeniedMask = 0;
+        for (ChallengeModeSettings setting : challengeModeList)
+        {
+            if (!sChallengeModes->challengeEnabled(setting))
+            {
+                continue;
+            }
+            ChallengeMapSet allowedMaps = LoadStringToMapSet(setting, ".AllowedMaps");
+            deniedMaps[setting] = LoadStringToMapSet(setting, ".DeniedMaps");
+            if (allowedMaps.any())
+            {
+                deniedMaps[setting] |= ~allowedMaps;
+            }
+            if (sConfigMgr->GetOption<bool>(std::string(ChallengeModes::getChallengeName(setting)) + ".DenyDungeonFinder", false))
+            {
+                sChallengeModes->dungeonFinderDeniedMask |= challengeModeMask(setting);
+            }
+        }
+
+        // Precompute every combination of challenges so a teleport only tests one bit
+        for (uint32 mask = 0; mask < sChallengeModes->deniedMapsByMask.size(); ++mask)
+        {
+            ChallengeMapSet& maps = sChallengeModes->deniedMapsByMask[mask];
+            maps.reset();
+            for (ChallengeModeSettings setting : challengeModeList)
+            {
+                if (mask & challengeModeMask(setting))
+                {
+                    maps |= deniedMaps[setting];
+                }
+            }
+        }
+    }
+
     static void LoadConfig()
     {
         sChallengeModes->challengesEnabled = sConfigMgr->GetOption<bool>("ChallengeModes.Enable", false);
@@ -277,6 +781,7 @@ private:
             sChallengeModes->verySlowXpGainEnable    = sConfigMgr->GetOption<bool>("VerySlowXpGain.Enable", true);
             sChallengeModes->questXpOnlyEnable       = sConfigMgr->GetOption<bool>("QuestXpOnly.Enable", true);
             sChallengeModes->ironManEnable           = sConfigMgr->GetOption<bool>("IronMan.Enable", true);
+            sChallengeModes->speedrunEnable          = sConfigMgr->GetOption<bool>("Speedrun.Enable", true);
 
             sChallengeModes->hardcoreDisableLevel          = sConfigMgr->GetOption<uint32>("Hardcore.DisableLevel", 0);
             sChallengeModes->semiHardcoreDisableLevel      = sConfigMgr->GetOption<uint32>("SemiHardcore.DisableLevel", 0);
@@ -286,6 +791,7 @@ private:
             sChallengeModes->verySlowXpGainDisableLevel    = sConfigMgr->GetOption<uint32>("VerySlowXpGain.DisableLevel", 0);
             sChallengeModes->questXpOnlyDisableLevel       = sConfigMgr->GetOption<uint32>("QuestXpOnly.DisableLevel", 0);
             sChallengeModes->ironManDisableLevel           = sConfigMgr->GetOption<uint32>("IronMan.DisableLevel", 0);
+            sChallengeModes->speedrunDisableLevel          = sConfigMgr->GetOption<uint32>("Speedrun.DisableLevel", 0);
 
             sChallengeModes->hardcoreXpBonus         = sConfigMgr->GetOption<float>("Hardcore.XPMultiplier", 1.0f);
             sChallengeModes->semiHardcoreXpBonus     = sConfigMgr->GetOption<float>("SemiHardcore.XPMultiplier", 1.0f);
@@ -295,6 +801,39 @@ private:
             sChallengeModes->slowXpGainBonus         = sConfigMgr->GetOption<float>("SlowXpGain.XPMultiplier", 0.50f);
             sChallengeModes->verySlowXpGainBonus     = sConfigMgr->GetOption<float>("VerySlowXpGain.XPMultiplier", 0.25f);
             sChallengeModes->ironManXpBonus          = sConfigMgr->GetOption<float>("IronMan.XPMultiplier", 1.0f);
+            sChallengeModes->speedrunXpBonus         = sConfigMgr->GetOption<float>("Speedrun.XPMultiplier", 1.0f);
+
+            LoadMapRestrictions();
+            LoadRewardLevels();
+
+            for (ChallengeModeSettings setting : challengeModeList)
+            {
+                LoadXpMultiplierTable(setting, sConfigMgr->GetOption<std::string>(std::string(ChallengeModes::getChallengeName(setting)) + ".XPMultiplierCurve", ""));
+            }
+
+            sChallengeModes->speedrunTargetLevel      = sConfigMgr->GetOption<uint32>("Speedrun.TargetLevel", 60);
+            sChallengeModes->speedrunTimeLimit        = sConfigMgr->GetOption<uint32>("Speedrun.TimeLimit", 96) * HOUR;
+            sChallengeModes->rewardDeliveryInterval   = sConfigMgr->GetOption<uint32>("ChallengeModes.Rewards.DeliveryInterval", 5000);
+            sChallengeModes->rewardDeliveryBatchSize  = sConfigMgr->GetOption<uint32>("ChallengeModes.Rewards.BatchSize", 50);
+            sChallengeModes->rewardAnnounce           = sConfigMgr->GetOption<bool>("ChallengeModes.Rewards.Announce", true);
+            sChallengeModes->backfillPageSize         = sConfigMgr->GetOption<uint32>("ChallengeModes.Backfill.PageSize", 500);
+            sChallengeModes->backfillInterval         = sConfigMgr->GetOption<uint32>("ChallengeModes.Backfill.Interval", 1000);
+            sChallengeModes->journalEnable            = sConfigMgr->GetOption<bool>("ChallengeModes.Journal.Enable", true);
+            sChallengeModes->journalFile              = sConfigMgr->GetOption<std::string>("ChallengeModes.Journal.File", "challenge_modes.journal");
+            sChallengeModes->journalCapacity          = sConfigMgr->GetOption<uint32>("ChallengeModes.Journal.Capacity", 262144);
+            sChallengeModes->statsEnable              = sConfigMgr->GetOption<bool>("ChallengeModes.Stats.Enable", true);
+            sChallengeModes->statsFlushInterval       = sConfigMgr->GetOption<uint32>("ChallengeModes.Stats.FlushInterval", 15);
+            sChallengeModes->statsExportFile          = sConfigMgr->GetOption<std::string>("ChallengeModes.Stats.ExportFile", "challenge_mode_stats.log");
+            sChallengeModes->provenanceEnable         = sConfigMgr->GetOption<bool>("ChallengeModes.ItemProvenance.Enable", true);
+            sChallengeModes->provenanceBlockTrade     = sConfigMgr->GetOption<bool>("ChallengeModes.ItemProvenance.BlockTrade", true);
+            sChallengeModes->provenanceBlockMail      = sConfigMgr->GetOption<bool>("ChallengeModes.ItemProvenance.BlockMail", true);
+            sChallengeModes->provenanceBlockAuction   = sConfigMgr->GetOption<bool>("ChallengeModes.ItemProvenance.BlockAuction", true);
+            sChallengeModes->leaderboardEnable        = sConfigMgr->GetOption<bool>("ChallengeModes.Leaderboard.Enable", false);
+            sChallengeModes->leaderboardFile          = sConfigMgr->GetOption<std::string>("ChallengeModes.Leaderboard.File", "challenge_leaderboard.jsonl");
+            sChallengeModes->leaderboardSnapshotFile  = sConfigMgr->GetOption<std::string>("ChallengeModes.Leaderboard.SnapshotFile", "challenge_leaderboard_snapshot.jsonl");
+            sChallengeModes->leaderboardInterval      = std::max<uint32>(sConfigMgr->GetOption<uint32>("ChallengeModes.Leaderboard.Interval", 5), 1);
+            sChallengeModes->leaderboardSnapshotInterval = sConfigMgr->GetOption<uint32>("ChallengeModes.Leaderboard.SnapshotInterval", 300);
+            sChallengeModes->deathKicksPerUpdate      = std::max<uint32>(sConfigMgr->GetOption<uint32>("ChallengeModes.Deaths.KicksPerUpdate", 5), 1);
 
             sChallengeModes->hardcoreItemRewardAmount         = sConfigMgr->GetOption<uint32>("Hardcore.ItemRewardAmount", 1);
             sChallengeModes->semiHardcoreItemRewardAmount     = sConfigMgr->GetOption<uint32>("SemiHardcore.ItemRewardAmount", 1);
@@ -304,6 +843,7 @@ private:
             sChallengeModes->verySlowXpGainItemRewardAmount   = sConfigMgr->GetOption<uint32>("VerySlowXpGain.ItemRewardAmount", 1);
             sChallengeModes->questXpOnlyItemRewardAmount      = sConfigMgr->GetOption<uint32>("QuestXpOnly.ItemRewardAmount", 1);
             sChallengeModes->ironManItemRewardAmount          = sConfigMgr->GetOption<uint32>("IronMan.ItemRewardAmount", 1);
+            sChallengeModes->speedrunItemRewardAmount         = sConfigMgr->GetOption<uint32>("Speedrun.ItemRewardAmount", 1);
 
             LoadStringToMap(sChallengeModes->hardcoreAchievementReward, sConfigMgr->GetOption<std::string>("Hardcore.AchievementReward", ""));
             LoadStringToMap(sChallengeModes->semiHardcoreAchievementReward, sConfigMgr->GetOption<std::string>("SemiHardcore.AchievementReward", ""));
@@ -313,6 +853,7 @@ private:
             LoadStringToMap(sChallengeModes->verySlowXpGainAchievementReward, sConfigMgr->GetOption<std::string>("VerySlowXpGain.AchievementReward", ""));
             LoadStringToMap(sChallengeModes->questXpOnlyAchievementReward, sConfigMgr->GetOption<std::string>("QuestXpOnly.AchievementReward", ""));
             LoadStringToMap(sChallengeModes->ironManAchievementReward, sConfigMgr->GetOption<std::string>("IronMan.AchievementReward", ""));
+            LoadStringToMap(sChallengeModes->speedrunAchievementReward, sConfigMgr->GetOption<std::string>("Speedrun.AchievementReward", ""));
         }
     }
 };
@@ -325,18 +866,15 @@ public:
             : PlayerScript(scriptName), settingName(settingName)
     { }
 
-    static bool mapContainsKey(const std::unordered_map<uint8, uint32>* mapToCheck, uint8 key)
-    {
-        return (mapToCheck->find(key) != mapToCheck->end());
-    }
-
-    void OnPlayerGiveXP(Player* player, uint32& amount, Unit* /*victim*/, uint8 /*xpSource*/) override
+    void OnPlayerGiveXP(Player* player, uint32& amount, Unit* /*victim*/, uint8 xpSource) override
     {
         if (!sChallengeModes->challengeEnabledForPlayer(settingName, player))
         {
             return;
         }
-        amount *= sChallengeModes->getXpBonusForChallenge(settingName);
+        uint32 multiplier = sChallengeModes->getXpMultiplier(settingName, player->GetLevel(), xpSource);
+        amount = uint32((uint64(amount) * multiplier) >> 16);
+        sChallengeModeJournal->Record(JOURNAL_EVENT_XP_GAIN, player, settingName, amount, multiplier, xpSource);
     }
 
 void OnPlayerLevelChanged(Player* player, uint8 /*oldlevel*/) override
@@ -346,55 +884,13 @@ void OnPlayerLevelChanged(Player* player, uint8 /*oldlevel*/) override
         return;
     }
 
-    const std::unordered_map<uint8, uint32>* titleRewardMap = sChallengeModes->getTitleMapForChallenge(settingName);
-    const std::unordered_map<uint8, uint32>* talentRewardMap = sChallengeModes->getTalentMapForChallenge(settingName);
-    const std::unordered_map<uint8, uint32>* itemRewardMap = sChallengeModes->getItemMapForChallenge(settingName);
-    const std::unordered_map<uint8, uint32>* achievementRewardMap = sChallengeModes->getAchievementMapForChallenge(settingName);
     uint8 level = player->GetLevel();
-
-    if (mapContainsKey(titleRewardMap, level))
-    {
-        CharTitlesEntry const* titleInfo = sCharTitlesStore.LookupEntry(titleRewardMap->at(level));
-        if (!titleInfo)
-        {
-            LOG_ERROR("mod-challenge-modes", "Invalid title ID {}!", titleRewardMap->at(level));
-            return;
-        }
-        ChatHandler handler(player->GetSession());
-        std::string tNameLink = handler.GetNameLink(player);
-        std::string titleNameStr = Acore::StringFormat(player->getGender() == GENDER_MALE ? titleInfo->nameMale[handler.GetSessionDbcLocale()] : titleInfo->nameFemale[handler.GetSessionDbcLocale()], player->GetName());
-        player->SetTitle(titleInfo);
-    }
-
-    if (mapContainsKey(talentRewardMap, level))
-    {
-        player->RewardExtraBonusTalentPoints(talentRewardMap->at(level));
-    }
-
-    if (mapContainsKey(achievementRewardMap, level))
-    {
-        AchievementEntry const* achievementInfo = sAchievementStore.LookupEntry(achievementRewardMap->at(level));
-        if (!achievementInfo)
-        {
-            LOG_ERROR("mod-challenge-modes", "Invalid Achievement ID {}!", achievementRewardMap->at(level));
-            return;
-        }
-
-        ChatHandler handler(player->GetSession());
-        std::string tNameLink = handler.GetNameLink(player);
-        player->CompletedAchievement(achievementInfo);
-    }
-
-    if (mapContainsKey(itemRewardMap, level))
-    {
-        uint32 itemEntry = itemRewardMap->at(level);
-        uint32 itemAmount = sChallengeModes->getItemRewardAmount(settingName); // Fetch item amount from config
-        player->SendItemRetrievalMail({ { itemEntry, itemAmount } });
-    }
+    // Rewards are only recorded here, the reward ledger delivers them from the world thread
+    sChallengeModeRewards->QueueLevelRewards(player, settingName, level);
 
     if (sChallengeModes->getDisableLevel(settingName) && sChallengeModes->getDisableLevel(settingName) <= level)
     {
-        player->UpdatePlayerSetting("mod-challenge-modes", settingName, 0);
+        ChallengeModes::setPlayerSetting(player, settingName, 0);
     }
 }
 
@@ -407,14 +903,32 @@ class ChallengeMode_Hardcore : public ChallengeMode
 public:
     ChallengeMode_Hardcore() : ChallengeMode("ChallengeMode_Hardcore", SETTING_HARDCORE) {}
 
+    static void MarkDead(Player* player)
+    {
+        if (ChallengeModes::getPlayerSettings(player).IsSet(HARDCORE_DEAD))
+        {
+            return;
+        }
+        ChallengeModes::setPlayerSetting(player, HARDCORE_DEAD, 1);
+        sChallengeModeLeaderboard->UpdatePlayer(player);
+        sChallengeModeDeaths->QueueDeath(player);
+    }
+
     void OnPlayerLogin(Player* player) override
     {
-        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_HARDCORE, player) || !sChallengeModes->challengeEnabledForPlayer(HARDCORE_DEAD, player))
+        // Characters revived by .challenge bulk revive while offline are resurrected here
+        if (ChallengeModes::getPlayerSettings(player).IsSet(HARDCORE_REVIVED))
+        {
+            ChallengeModes::setPlayerSetting(player, HARDCORE_REVIVED, 0);
+            ChallengeModes::reviveHardcorePlayer(player);
+            return;
+        }
+        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_HARDCORE, player) || !ChallengeModes::getPlayerSettings(player).IsSet(HARDCORE_DEAD))
         {
             return;
         }
         player->KillPlayer();
-        player->GetSession()->KickPlayer(std::string("极限模式角色已死亡"));
+        sChallengeModeDeaths->QueueKick(player);
     }
 
     void OnPlayerReleasedGhost(Player* player) override
@@ -423,8 +937,8 @@ public:
         {
             return;
         }
-        player->UpdatePlayerSetting("mod-challenge-modes", HARDCORE_DEAD, 1);
-        player->GetSession()->KickPlayer(std::string("极限模式角色已死亡"));
+        MarkDead(player);
+        sChallengeModeDeaths->QueueKick(player);
     }
 
     void OnPlayerPVPKill(Player* /*killer*/, Player* killed) override
@@ -433,7 +947,7 @@ public:
         {
             return;
         }
-        killed->UpdatePlayerSetting("mod-challenge-modes", HARDCORE_DEAD, 1);
+        MarkDead(killed);
     }
 
     void OnPlayerKilledByCreature(Creature* /*killer*/, Player* killed) override
@@ -442,19 +956,19 @@ public:
         {
             return;
         }
-        killed->UpdatePlayerSetting("mod-challenge-modes", HARDCORE_DEAD, 1);
+        MarkDead(killed);
     }
 
     void OnPlayerResurrect(Player* player, float /*restore_percent*/, bool /*applySickness*/) override
     {
-        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_HARDCORE, player))
+        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_HARDCORE, player) || ChallengeModes::isGmRevive(player))
         {
             return;
         }
         // A better implementation is to not allow the resurrect but this will need a new hook added first
-        player->UpdatePlayerSetting("mod-challenge-modes", HARDCORE_DEAD, 1);
+        MarkDead(player);
         player->KillPlayer();
-        player->GetSession()->KickPlayer(std::string("极限模式角色已死亡"));
+        sChallengeModeDeaths->QueueKick(player);
     }
 
     void OnPlayerGiveXP(Player* player, uint32& amount, Unit* victim, uint8 xpSource) override
@@ -509,17 +1023,29 @@ class ChallengeMode_SelfCrafted : public ChallengeMode
 public:
     ChallengeMode_SelfCrafted() : ChallengeMode("ChallengeMode_SelfCrafted", SETTING_SELF_CRAFTED) {}
 
-    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool /*not_loading*/) override
+    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool not_loading) override
     {
+        if (sChallengeModes->gearValidatedForLogin(player, not_loading))
+        {
+            return true;
+        }
         if (!sChallengeModes->challengeEnabledForPlayer(SETTING_SELF_CRAFTED, player))
         {
             return true;
         }
-        if (!pItem->GetTemplate()->HasSignature())
+        if (!pItem->GetTemplate()->HasSignature() || pItem->GetGuidValue(ITEM_FIELD_CREATOR) != player->GetGUID())
+        {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_EQUIP_BLOCKED, player, SETTING_SELF_CRAFTED, pItem->GetEntry());
+            sChallengeModeStats->RecordEquipDenied(SETTING_SELF_CRAFTED);
+            return false;
+        }
+        if (!sChallengeModeProvenance->ObtainedByOwner(player, pItem))
         {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_EQUIP_BLOCKED, player, SETTING_SELF_CRAFTED, pItem->GetEntry());
+            sChallengeModeStats->RecordEquipDenied(SETTING_SELF_CRAFTED);
             return false;
         }
-        return pItem->GetGuidValue(ITEM_FIELD_CREATOR) == player->GetGUID();
+        return true;
     }
 
     void OnPlayerGiveXP(Player* player, uint32& amount, Unit* victim, uint8 xpSource) override
@@ -538,13 +1064,23 @@ class ChallengeMode_ItemQualityLevel : public ChallengeMode
 public:
     ChallengeMode_ItemQualityLevel() : ChallengeMode("ChallengeMode_ItemQualityLevel", SETTING_ITEM_QUALITY_LEVEL) {}
 
-    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool /*not_loading*/) override
+    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool not_loading) override
     {
+        if (sChallengeModes->gearValidatedForLogin(player, not_loading))
+        {
+            return true;
+        }
         if (!sChallengeModes->challengeEnabledForPlayer(SETTING_ITEM_QUALITY_LEVEL, player))
         {
             return true;
         }
-        return pItem->GetTemplate()->Quality <= ITEM_QUALITY_NORMAL;
+        if (pItem->GetTemplate()->Quality > ITEM_QUALITY_NORMAL)
+        {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_EQUIP_BLOCKED, player, SETTING_ITEM_QUALITY_LEVEL, pItem->GetEntry());
+            sChallengeModeStats->RecordEquipDenied(SETTING_ITEM_QUALITY_LEVEL);
+            return false;
+        }
+        return true;
     }
 
     void OnPlayerGiveXP(Player* player, uint32& amount, Unit* victim, uint8 xpSource) override
@@ -628,7 +1164,7 @@ public:
 
     void OnPlayerResurrect(Player* player, float /*restore_percent*/, bool /*applySickness*/) override
     {
-        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_IRON_MAN, player))
+        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_IRON_MAN, player) || ChallengeModes::isGmRevive(player))
         {
             return;
         }
@@ -660,13 +1196,29 @@ public:
         player->SetFreeTalentPoints(0); // Remove all talent points
     }
 
-    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool /*not_loading*/) override
+    bool OnPlayerCanEquipItem(Player* player, uint8 /*slot*/, uint16& /*dest*/, Item* pItem, bool /*swap*/, bool not_loading) override
     {
+        if (sChallengeModes->gearValidatedForLogin(player, not_loading))
+        {
+            return true;
+        }
         if (!sChallengeModes->challengeEnabledForPlayer(SETTING_IRON_MAN, player))
         {
             return true;
         }
-        return pItem->GetTemplate()->Quality <= ITEM_QUALITY_NORMAL;
+        if (pItem->GetTemplate()->Quality > ITEM_QUALITY_NORMAL)
+        {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_EQUIP_BLOCKED, player, SETTING_IRON_MAN, pItem->GetEntry());
+            sChallengeModeStats->RecordEquipDenied(SETTING_IRON_MAN);
+            return false;
+        }
+        if (!sChallengeModeProvenance->ObtainedByOwner(player, pItem))
+        {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_EQUIP_BLOCKED, player, SETTING_IRON_MAN, pItem->GetEntry());
+            sChallengeModeStats->RecordEquipDenied(SETTING_IRON_MAN);
+            return false;
+        }
+        return true;
     }
 
     bool OnPlayerCanApplyEnchantment(Player* player, Item* /*item*/, EnchantmentSlot /*slot*/, bool /*apply*/, bool /*apply_dur*/, bool /*ignore_condition*/) override
@@ -725,6 +1277,8 @@ public:
                 proto->SubClass == ITEM_SUBCLASS_ELIXIR ||
                 proto->SubClass == ITEM_SUBCLASS_FLASK))
         {
+            sChallengeModeJournal->Record(JOURNAL_EVENT_USE_BLOCKED, player, SETTING_IRON_MAN, proto->ItemId);
+            sChallengeModeStats->RecordUseDenied(SETTING_IRON_MAN);
             return false;
         }
         // Do not allow food that gives food buffs
@@ -740,6 +1294,8 @@ public:
                 {
                     if (spellInfo->Effects[i].ApplyAuraName == SPELL_AURA_PERIODIC_TRIGGER_SPELL)
                     {
+                        sChallengeModeJournal->Record(JOURNAL_EVENT_USE_BLOCKED, player, SETTING_IRON_MAN, proto->ItemId);
+                        sChallengeModeStats->RecordUseDenied(SETTING_IRON_MAN);
                         return false;
                     }
                 }
@@ -768,64 +1324,203 @@ public:
 
 };
 
-class gobject_challenge_modes : public GameObjectScript
+class ChallengeModes_MapRestrictions : public PlayerScript
 {
-private:
-    static bool playerSettingEnabled(Player* player, uint8 settingIndex)
+public:
+    ChallengeModes_MapRestrictions() : PlayerScript("ChallengeModes_MapRestrictions") { }
+
+    bool OnPlayerBeforeTeleport(Player* player, uint32 mapid, float /*x*/, float /*y*/, float /*z*/, float /*orientation*/, uint32 /*options*/, Unit* /*target*/) override
+    {
+        if (!sChallengeModes->enabled() || mapid == player->GetMapId())
+        {
+            return true;
+        }
+        // The challenge mask is read from the cached settings, so a teleport costs one bit test in the precomputed map set
+        if (sChallengeModes->mapDeniedForMask(ChallengeModes::getPlayerSettings(player).GetChallengeMask(), mapid))
+        {
+            ChatHandler(player->GetSession()).SendSysMessage("你的挑战模式禁止进入该地图。");
+            return false;
+        }
+        return true;
+    }
+
+    bool OnPlayerCanJoinLfg(Player* player, uint8 /*roles*/, lfg::LfgDungeonSet& /*dungeons*/, const std::string& /*comment*/) override
     {
-        return player->GetPlayerSetting("mod-challenge-modes", settingIndex).value;
+        if (!sChallengeModes->enabled() || !(ChallengeModes::getPlayerSettings(player).GetChallengeMask() & sChallengeModes->dungeonFinderDeniedMask))
+        {
+            return true;
+        }
+        ChatHandler(player->GetSession()).SendSysMessage("你的挑战模式禁止使用地下城查找器。");
+        return false;
     }
+};
 
+class ChallengeModes_PlayerSettings : public PlayerScript
+{
 public:
-    gobject_challenge_modes() : GameObjectScript("gobject_challenge_modes") { }
+    ChallengeModes_PlayerSettings() : PlayerScript("ChallengeModes_PlayerSettings") { }
 
-    struct gobject_challenge_modesAI: GameObjectAI
+    // The core has loaded character_settings by now, every later hook reads the cached copy
+    void OnPlayerLoadFromDB(Player* player) override
     {
-        explicit gobject_challenge_modesAI(GameObject* object) : GameObjectAI(object) { };
+        ChallengeModes::loadPlayerSettings(player);
+    }
+};
 
-        bool CanBeSeen(Player const* player) override
+class ChallengeModes_GearValidation : public PlayerScript
+{
+public:
+    ChallengeModes_GearValidation() : PlayerScript("ChallengeModes_GearValidation") { }
+
+    void OnPlayerLogin(Player* player) override
+    {
+        ChallengeModes::resetGearValidationCache();
+        if (!sChallengeModes->enabled())
         {
-            if ((player->GetLevel() > 1 && player->getClass() != CLASS_DEATH_KNIGHT) || (player->GetLevel() > 55))
-            {
-                return false;
-            }
-            return sChallengeModes->enabled();
+            return;
         }
-    };
+        // Gear that failed the equip checks was unequipped while loading, so everything worn now is valid under the current rules.
+        // Item provenance loads after this, ChallengeModeProvenance unequips worn items that turn out to be tagged.
+        uint32 stamp = sChallengeModes->getGearValidationStamp(player);
+        if (ChallengeModes::getPlayerSettings(player).Get(GEAR_VALIDATED_STAMP) != stamp)
+        {
+            ChallengeModes::setPlayerSetting(player, GEAR_VALIDATED_STAMP, stamp);
+        }
+    }
+};
 
-    bool OnGossipHello(Player* player, GameObject* go) override
+class ChallengeMode_Speedrun : public ChallengeMode
+{
+public:
+    ChallengeMode_Speedrun() : ChallengeMode("ChallengeMode_Speedrun", SETTING_SPEEDRUN) {}
+
+    void OnPlayerLogin(Player* player) override
     {
-        if (sChallengeModes->challengeEnabled(SETTING_HARDCORE) && !playerSettingEnabled(player, SETTING_HARDCORE) && !playerSettingEnabled(player, SETTING_SEMI_HARDCORE))
+        sChallengeModeSpeedrun->Arm(player);
+    }
+
+    void OnPlayerLogout(Player* player) override
+    {
+        sChallengeModeSpeedrun->Disarm(player->GetGUID().GetCounter());
+    }
+
+    void OnPlayerGiveXP(Player* player, uint32& amount, Unit* victim, uint8 xpSource) override
+    {
+        ChallengeMode::OnPlayerGiveXP(player, amount, victim, xpSource);
+    }
+
+    void OnPlayerLevelChanged(Player* player, uint8 oldlevel) override
+    {
+        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player))
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用极限模式", 0, SETTING_HARDCORE);
+            return;
         }
-        if (sChallengeModes->challengeEnabled(SETTING_SEMI_HARDCORE) && !playerSettingEnabled(player, SETTING_HARDCORE) && !playerSettingEnabled(player, SETTING_SEMI_HARDCORE))
+        sChallengeModeSpeedrun->RecordSplit(player, player->GetLevel());
+        ChallengeMode::OnPlayerLevelChanged(player, oldlevel);
+        // The challenge ends at the target level or when DisableLevel turned it off
+        if (!sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player) || player->GetLevel() >= sChallengeModes->speedrunTargetLevel)
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用半极限模式", 0, SETTING_SEMI_HARDCORE);
+            sChallengeModeSpeedrun->Disarm(player->GetGUID().GetCounter());
+            return;
         }
-        if (sChallengeModes->challengeEnabled(SETTING_SELF_CRAFTED) && !playerSettingEnabled(player, SETTING_SELF_CRAFTED) && !playerSettingEnabled(player, SETTING_IRON_MAN))
+        sChallengeModeSpeedrun->Arm(player);
+    }
+};
+
+class gobject_challenge_modes : public GameObjectScript
+{
+private:
+    static constexpr uint32 GOSSIP_ACTION_SPEEDRUN_SPLITS = 100;
+
+    static char const* challengeGossipText(ChallengeModeSettings setting)
+    {
+        switch (setting)
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用自制装备模式", 0, SETTING_SELF_CRAFTED);
+            case SETTING_HARDCORE:
+                return "启用极限模式";
+            case SETTING_SEMI_HARDCORE:
+                return "启用半极限模式";
+            case SETTING_SELF_CRAFTED:
+                return "启用自制装备模式";
+            case SETTING_ITEM_QUALITY_LEVEL:
+                return "启用低品质装备模式";
+            case SETTING_SLOW_XP_GAIN:
+                return "启用慢速经验模式";
+            case SETTING_VERY_SLOW_XP_GAIN:
+                return "启用极慢经验模式";
+            case SETTING_QUEST_XP_ONLY:
+                return "启用任务经验专属模式";
+            case SETTING_IRON_MAN:
+                return "启用铁人模式";
+            case SETTING_SPEEDRUN:
+                return "启用速通模式";
+            case HARDCORE_DEAD:
+            case GEAR_VALIDATED_STAMP:
+            case HARDCORE_REVIVED:
+                break;
         }
-        if (sChallengeModes->challengeEnabled(SETTING_ITEM_QUALITY_LEVEL) && !playerSettingEnabled(player, SETTING_ITEM_QUALITY_LEVEL))
+        return "";
+    }
+
+    static bool canChangeChallenges(Player const* player)
+    {
+        if (player->GetLevel() > ChallengeModes::getEnrollLevel(player->getClass()))
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用低品质装备模式", 0, SETTING_ITEM_QUALITY_LEVEL);
+            return false;
         }
-        if (sChallengeModes->challengeEnabled(SETTING_SLOW_XP_GAIN) && !playerSettingEnabled(player, SETTING_SLOW_XP_GAIN) && !playerSettingEnabled(player, SETTING_VERY_SLOW_XP_GAIN))
+        return sChallengeModes->enabled();
+    }
+
+    static std::string formatPlayedTime(uint32 seconds)
+    {
+        return Acore::StringFormat("{}:{:02}:{:02}", seconds / HOUR, (seconds % HOUR) / MINUTE, seconds % MINUTE);
+    }
+
+    static void showSpeedrunSplits(Player* player)
+    {
+        ChatHandler handler(player->GetSession());
+        handler.SendSysMessage(Acore::StringFormat("速通目标: {} 级, 剩余游戏时间: {}", sChallengeModes->speedrunTargetLevel,
+            formatPlayedTime(ChallengeModeSpeedrun::GetRemainingTime(player))));
+        uint8 lastLevel = std::min<uint32>(player->GetLevel(), sChallengeModes->speedrunTargetLevel);
+        for (uint8 level = 1; level <= lastLevel; ++level)
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用慢速经验模式", 0, SETTING_SLOW_XP_GAIN);
+            if (uint32 split = player->GetPlayerSetting(challengeModeSplitsSource, level).value)
+            {
+                handler.SendSysMessage(Acore::StringFormat("等级 {}: {}", level, formatPlayedTime(split)));
+            }
         }
-        if (sChallengeModes->challengeEnabled(SETTING_VERY_SLOW_XP_GAIN) && !playerSettingEnabled(player, SETTING_SLOW_XP_GAIN) && !playerSettingEnabled(player, SETTING_VERY_SLOW_XP_GAIN))
+    }
+
+public:
+    gobject_challenge_modes() : GameObjectScript("gobject_challenge_modes") { }
+
+    struct gobject_challenge_modesAI: GameObjectAI
+    {
+        explicit gobject_challenge_modesAI(GameObject* object) : GameObjectAI(object) { };
+
+        bool CanBeSeen(Player const* player) override
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用极慢经验模式", 0, SETTING_VERY_SLOW_XP_GAIN);
+            // Speedrun characters keep seeing the shrine to check their split times, reading player settings is not const
+            return canChangeChallenges(player) || sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, const_cast<Player*>(player));
         }
-        if (sChallengeModes->challengeEnabled(SETTING_QUEST_XP_ONLY) && !playerSettingEnabled(player, SETTING_QUEST_XP_ONLY))
+    };
+
+    bool OnGossipHello(Player* player, GameObject* go) override
+    {
+        uint32 playerMask = ChallengeModes::getPlayerChallengeMask(player);
+        if (canChangeChallenges(player))
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用任务经验专属模式", 0, SETTING_QUEST_XP_ONLY);
+            for (ChallengeModeSettings setting : challengeModeList)
+            {
+                if (sChallengeModes->challengeEnabled(setting) && challengeModeAllowed(setting, playerMask))
+                {
+                    AddGossipItemFor(player, GOSSIP_ICON_CHAT, challengeGossipText(setting), 0, setting);
+                }
+            }
         }
-        if (sChallengeModes->challengeEnabled(SETTING_IRON_MAN) && !playerSettingEnabled(player, SETTING_IRON_MAN) && !playerSettingEnabled(player, SETTING_SELF_CRAFTED))
+        if (sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player))
         {
-            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "启用铁人模式", 0, SETTING_IRON_MAN);
+            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "查看速通分段计时", 0, GOSSIP_ACTION_SPEEDRUN_SPLITS);
         }
         SendGossipMenuFor(player, 12669, go->GetGUID());
         return true;
@@ -833,7 +1528,28 @@ public:
 
     bool OnGossipSelect(Player* player, GameObject* /*go*/, uint32 /*sender*/, uint32 action) override
     {
-        player->UpdatePlayerSetting("mod-challenge-modes", action, 1);
+        if (action == GOSSIP_ACTION_SPEEDRUN_SPLITS && sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player))
+        {
+            showSpeedrunSplits(player);
+            CloseGossipMenuFor(player);
+            return true;
+        }
+        // The action comes from the client, so apply the same checks as the menu
+        if (action >= MAX_CHALLENGE_MODE_SETTING || !canChangeChallenges(player) ||
+            !sChallengeModes->challengeEnabled(ChallengeModeSettings(action)) ||
+            !challengeModeAllowed(ChallengeModeSettings(action), ChallengeModes::getPlayerChallengeMask(player)))
+        {
+            CloseGossipMenuFor(player);
+            return true;
+        }
+        ChallengeModes::setPlayerSetting(player, action, 1);
+        sChallengeModeLeaderboard->UpdatePlayer(player);
+        if (action == SETTING_SPEEDRUN)
+        {
+            // The split of the starting level marks the played time the run started at
+            sChallengeModeSpeedrun->RecordSplit(player, player->GetLevel());
+            sChallengeModeSpeedrun->Arm(player);
+        }
         ChatHandler(player->GetSession()).PSendSysMessage("挑战模式已启用。");
         CloseGossipMenuFor(player);
         return true;
@@ -850,6 +1566,9 @@ void AddSC_mod_challenge_modes()
 {
     new ChallengeModes_WorldScript();
     new gobject_challenge_modes();
+    new ChallengeModes_PlayerSettings();
+    new ChallengeModes_GearValidation();
+    new ChallengeModes_MapRestrictions();
     new ChallengeMode_Hardcore();
     new ChallengeMode_SemiHardcore();
     new ChallengeMode_SelfCrafted();
@@ -858,4 +1577,5 @@ void AddSC_mod_challenge_modes()
     new ChallengeMode_VerySlowXpGain();
     new ChallengeMode_QuestXpOnly();
     new ChallengeMode_IronMan();
+    new ChallengeMode_Speedrun();
 }
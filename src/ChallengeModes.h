@@ -12,20 +12,55 @@
 #include "ItemTemplate.h"
 #include "GameObjectAI.h"
 #include "Pet.h"
+#include "ChallengeModesSettings.h"
+#include <array>
+#include <bitset>
 #include <map>
 
 
-enum ChallengeModeSettings
+constexpr uint8 MAX_CHALLENGE_XP_SOURCE   = XPSOURCE_BATTLEGROUND + 1;
+constexpr uint32 XP_MULTIPLIER_ONE        = 1 << 16; // XP multipliers are 16.16 fixed point
+
+// Modes that cannot be enabled while the indexed mode is enabled, including the mode itself
+constexpr uint32 challengeModeConflicts[MAX_CHALLENGE_MODE_SETTING] =
+{
+    /* SETTING_HARDCORE           */ challengeModeMask(SETTING_HARDCORE) | challengeModeMask(SETTING_SEMI_HARDCORE),
+    /* SETTING_SEMI_HARDCORE      */ challengeModeMask(SETTING_SEMI_HARDCORE) | challengeModeMask(SETTING_HARDCORE),
+    /* SETTING_SELF_CRAFTED       */ challengeModeMask(SETTING_SELF_CRAFTED) | challengeModeMask(SETTING_IRON_MAN),
+    /* SETTING_ITEM_QUALITY_LEVEL */ challengeModeMask(SETTING_ITEM_QUALITY_LEVEL),
+    /* SETTING_SLOW_XP_GAIN       */ challengeModeMask(SETTING_SLOW_XP_GAIN) | challengeModeMask(SETTING_VERY_SLOW_XP_GAIN),
+    /* SETTING_VERY_SLOW_XP_GAIN  */ challengeModeMask(SETTING_VERY_SLOW_XP_GAIN) | challengeModeMask(SETTING_SLOW_XP_GAIN),
+    /* SETTING_QUEST_XP_ONLY      */ challengeModeMask(SETTING_QUEST_XP_ONLY),
+    /* SETTING_IRON_MAN           */ challengeModeMask(SETTING_IRON_MAN) | challengeModeMask(SETTING_SELF_CRAFTED),
+    /* HARDCORE_DEAD              */ 0,
+    /* GEAR_VALIDATED_STAMP       */ 0,
+    /* SETTING_SPEEDRUN           */ challengeModeMask(SETTING_SPEEDRUN),
+    /* HARDCORE_REVIVED           */ 0
+};
+
+// A mode can be enabled when none of its conflicting modes are in the player's challenge mask
+constexpr bool challengeModeAllowed(ChallengeModeSettings setting, uint32 playerMask)
+{
+    return !(challengeModeConflicts[setting] & playerMask);
+}
+
+// Modes that restrict which items can be equipped
+constexpr uint32 equipRuleChallengeMask = challengeModeMask(SETTING_SELF_CRAFTED) | challengeModeMask(SETTING_ITEM_QUALITY_LEVEL) | challengeModeMask(SETTING_IRON_MAN);
+// Bump when the equip rules change so gear validated under the old rules is checked again
+constexpr uint32 GEAR_RULES_VERSION = 2;
+// Set in the gear validation stamp while item provenance is enforced, so enabling it revalidates gear checked without it
+constexpr uint32 GEAR_RULES_PROVENANCE = 1 << 15;
+
+// Map IDs above the range of 3.3.5a Map.dbc are never restricted
+constexpr uint32 MAX_CHALLENGE_MAP_ID = 1024;
+typedef std::bitset<MAX_CHALLENGE_MAP_ID> ChallengeMapSet;
+
+// Final XP multiplier for every level and XP source, compiled from <Challenge>.XPMultiplier and <Challenge>.XPMultiplierCurve
+typedef std::array<std::array<uint32, MAX_CHALLENGE_XP_SOURCE>, 256> ChallengeXpMultiplierTable;
+
+// Cached settings of a loaded character, stored in Player::CustomData under challengeModeSettingSource
+class ChallengeModePlayerData : public DataMap::Base, public ChallengeModePlayerSettings
 {
-    SETTING_HARDCORE           = 0,
-    SETTING_SEMI_HARDCORE      = 1,
-    SETTING_SELF_CRAFTED       = 2,
-    SETTING_ITEM_QUALITY_LEVEL = 3,
-    SETTING_SLOW_XP_GAIN       = 4,
-    SETTING_VERY_SLOW_XP_GAIN  = 5,
-    SETTING_QUEST_XP_ONLY      = 6,
-    SETTING_IRON_MAN           = 7,
-    HARDCORE_DEAD              = 8
 };
 
 enum AllowedProfessions
@@ -42,13 +77,25 @@ class ChallengeModes
 public:
     static ChallengeModes* instance();
 
-    bool challengesEnabled, hardcoreEnable, semiHardcoreEnable, selfCraftedEnable, itemQualityLevelEnable, slowXpGainEnable, verySlowXpGainEnable, questXpOnlyEnable, ironManEnable;
-    uint32 hardcoreDisableLevel, semiHardcoreDisableLevel, selfCraftedDisableLevel, itemQualityLevelDisableLevel, slowXpGainDisableLevel, verySlowXpGainDisableLevel, questXpOnlyDisableLevel, ironManDisableLevel, hardcoreItemRewardAmount, semiHardcoreItemRewardAmount, selfCraftedItemRewardAmount, itemQualityLevelItemRewardAmount, slowXpGainItemRewardAmount, verySlowXpGainItemRewardAmount, questXpOnlyItemRewardAmount, ironManItemRewardAmount;
-    float hardcoreXpBonus, semiHardcoreXpBonus, selfCraftedXpBonus, itemQualityLevelXpBonus, questXpOnlyXpBonus, slowXpGainBonus, verySlowXpGainBonus, ironManXpBonus;
-    std::unordered_map<uint8, uint32> hardcoreTitleRewards, semiHardcoreTitleRewards, selfCraftedTitleRewards, itemQualityLevelTitleRewards, slowXpGainTitleRewards, verySlowXpGainTitleRewards, questXpOnlyTitleRewards, ironManTitleRewards;
-    std::unordered_map<uint8, uint32> hardcoreItemRewards, semiHardcoreItemRewards, selfCraftedItemRewards, itemQualityLevelItemRewards, slowXpGainItemRewards, verySlowXpGainItemRewards, questXpOnlyItemRewards, ironManItemRewards;
-    std::unordered_map<uint8, uint32> hardcoreTalentRewards, semiHardcoreTalentRewards, selfCraftedTalentRewards, itemQualityLevelTalentRewards, slowXpGainTalentRewards, verySlowXpGainTalentRewards, questXpOnlyTalentRewards, ironManTalentRewards;
-    std::unordered_map<uint8, uint32> hardcoreAchievementReward, semiHardcoreAchievementReward, selfCraftedAchievementReward, itemQualityLevelAchievementReward, slowXpGainAchievementReward, verySlowXpGainAchievementReward, questXpOnlyAchievementReward, ironManAchievementReward;
+    bool challengesEnabled, hardcoreEnable, semiHardcoreEnable, selfCraftedEnable, itemQualityLevelEnable, slowXpGainEnable, verySlowXpGainEnable, questXpOnlyEnable, ironManEnable, speedrunEnable;
+    uint32 hardcoreDisableLevel, semiHardcoreDisableLevel, selfCraftedDisableLevel, itemQualityLevelDisableLevel, slowXpGainDisableLevel, verySlowXpGainDisableLevel, questXpOnlyDisableLevel, ironManDisableLevel, speedrunDisableLevel, hardcoreItemRewardAmount, semiHardcoreItemRewardAmount, selfCraftedItemRewardAmount, itemQualityLevelItemRewardAmount, slowXpGainItemRewardAmount, verySlowXpGainItemRewardAmount, questXpOnlyItemRewardAmount, ironManItemRewardAmount, speedrunItemRewardAmount;
+    uint32 speedrunTargetLevel, speedrunTimeLimit;
+    uint32 rewardDeliveryInterval, rewardDeliveryBatchSize, backfillPageSize, backfillInterval, journalCapacity, statsFlushInterval, leaderboardInterval, leaderboardSnapshotInterval, deathKicksPerUpdate;
+    bool rewardAnnounce, journalEnable, statsEnable, provenanceEnable, provenanceBlockTrade, provenanceBlockMail, provenanceBlockAuction, leaderboardEnable;
+    std::string journalFile, statsExportFile, leaderboardFile, leaderboardSnapshotFile;
+    float hardcoreXpBonus, semiHardcoreXpBonus, selfCraftedXpBonus, itemQualityLevelXpBonus, questXpOnlyXpBonus, slowXpGainBonus, verySlowXpGainBonus, ironManXpBonus, speedrunXpBonus;
+    std::array<ChallengeXpMultiplierTable, MAX_CHALLENGE_MODE_SETTING> xpMultiplierTables;
+    // Level ups without rewards skip the reward maps
+    ChallengeRewardLevels rewardLevels;
+    // Maps denied to every combination of enabled challenges, compiled from <Challenge>.DeniedMaps and <Challenge>.AllowedMaps
+    // Only challenge bits are part of the mask, the character state settings after SETTING_SPEEDRUN do not enlarge the table
+    std::array<ChallengeMapSet, 1 << (SETTING_SPEEDRUN + 1)> deniedMapsByMask;
+    static_assert(challengeModeListMask < (1 << (SETTING_SPEEDRUN + 1)), "Every challenge mask must have its denied maps");
+    uint32 dungeonFinderDeniedMask;
+    std::unordered_map<uint8, uint32> hardcoreTitleRewards, semiHardcoreTitleRewards, selfCraftedTitleRewards, itemQualityLevelTitleRewards, slowXpGainTitleRewards, verySlowXpGainTitleRewards, questXpOnlyTitleRewards, ironManTitleRewards, speedrunTitleRewards;
+    std::unordered_map<uint8, uint32> hardcoreItemRewards, semiHardcoreItemRewards, selfCraftedItemRewards, itemQualityLevelItemRewards, slowXpGainItemRewards, verySlowXpGainItemRewards, questXpOnlyItemRewards, ironManItemRewards, speedrunItemRewards;
+    std::unordered_map<uint8, uint32> hardcoreTalentRewards, semiHardcoreTalentRewards, selfCraftedTalentRewards, itemQualityLevelTalentRewards, slowXpGainTalentRewards, verySlowXpGainTalentRewards, questXpOnlyTalentRewards, ironManTalentRewards, speedrunTalentRewards;
+    std::unordered_map<uint8, uint32> hardcoreAchievementReward, semiHardcoreAchievementReward, selfCraftedAchievementReward, itemQualityLevelAchievementReward, slowXpGainAchievementReward, verySlowXpGainAchievementReward, questXpOnlyAchievementReward, ironManAchievementReward, speedrunAchievementReward;
 
     std::unordered_map<std::string, std::unordered_map<uint8, uint32>*> rewardConfigMap =
             {
@@ -60,6 +107,7 @@ public:
                     { "VerySlowXpGain.TitleRewards",          &verySlowXpGainTitleRewards           },
                     { "QuestXpOnly.TitleRewards",             &questXpOnlyTitleRewards              },
                     { "IronMan.TitleRewards",                 &ironManTitleRewards                  },
+                    { "Speedrun.TitleRewards",                &speedrunTitleRewards                 },
 
                     { "Hardcore.TalentRewards",               &hardcoreTalentRewards                },
                     { "SemiHardcore.TalentRewards",           &semiHardcoreTalentRewards            },
@@ -69,6 +117,7 @@ public:
                     { "VerySlowXpGain.TalentRewards",         &verySlowXpGainTalentRewards          },
                     { "QuestXpOnly.TalentRewards",            &questXpOnlyTalentRewards             },
                     { "IronMan.TalentRewards",                &ironManTalentRewards                 },
+                    { "Speedrun.TalentRewards",               &speedrunTalentRewards                },
 
                     { "Hardcore.ItemRewards",                 &hardcoreItemRewards                  },
                     { "SemiHardcore.ItemRewards",             &semiHardcoreItemRewards              },
@@ -78,6 +127,7 @@ public:
                     { "VerySlowXpGain.ItemRewards",           &verySlowXpGainItemRewards            },
                     { "QuestXpOnly.ItemRewards",              &questXpOnlyItemRewards               },
                     { "IronMan.ItemRewards",                  &ironManItemRewards                   },
+                    { "Speedrun.ItemRewards",                 &speedrunItemRewards                  },
 
                     { "Hardcore.AchievementReward",           &hardcoreAchievementReward            },
                     { "SemiHardcore.AchievementReward",       &semiHardcoreAchievementReward        },
@@ -86,19 +136,56 @@ public:
                     { "SlowXpGain.AchievementReward",         &slowXpGainAchievementReward          },
                     { "VerySlowXpGain.AchievementReward",     &verySlowXpGainAchievementReward      },
                     { "QuestXpOnly.AchievementReward",        &questXpOnlyAchievementReward         },
-                    { "IronMan.AchievementReward",            &ironManAchievementReward             }
+                    { "IronMan.AchievementReward",            &ironManAchievementReward             },
+                    { "Speedrun.AchievementReward",           &speedrunAchievementReward            }
             };
 
     [[nodiscard]] bool enabled() const { return challengesEnabled; }
     [[nodiscard]] bool challengeEnabled(ChallengeModeSettings setting) const;
     [[nodiscard]] uint32 getDisableLevel(ChallengeModeSettings setting) const;
     [[nodiscard]] float getXpBonusForChallenge(ChallengeModeSettings setting) const;
+    [[nodiscard]] uint32 getXpMultiplier(ChallengeModeSettings setting, uint8 level, uint8 xpSource) const
+    {
+        return xpMultiplierTables[setting][level][xpSource < MAX_CHALLENGE_XP_SOURCE ? xpSource : uint8(XPSOURCE_KILL)];
+    }
     bool challengeEnabledForPlayer(ChallengeModeSettings setting, Player* player) const;
+    [[nodiscard]] static uint32 getPlayerChallengeMask(Player* player) { return getPlayerSettings(player).GetChallengeMask(); }
+    // Hooks read the module's settings from the cached copy, and every change goes through setPlayerSetting to keep it in step
+    [[nodiscard]] static ChallengeModePlayerSettings getPlayerSettings(Player* player);
+    // Cached copy of the module's settings, nullptr until loadPlayerSettings filled it once the character loaded
+    [[nodiscard]] static ChallengeModePlayerData* getPlayerData(Player* player);
+    static void loadPlayerSettings(Player* player);
+    static void setPlayerSetting(Player* player, uint8 settingIndex, uint32 value);
+    [[nodiscard]] bool hasRewardAtLevel(ChallengeModeSettings setting, uint8 level) const
+    {
+        return rewardLevels[setting].test(level);
+    }
+    [[nodiscard]] bool mapDeniedForMask(uint32 playerMask, uint32 mapId) const
+    {
+        return mapId < MAX_CHALLENGE_MAP_ID && deniedMapsByMask[playerMask & (deniedMapsByMask.size() - 1)].test(mapId);
+    }
+    // Clears the hardcore death of an online character and resurrects it, the resurrect hooks let GM revives through
+    static void reviveHardcorePlayer(Player* player);
+    [[nodiscard]] static bool isGmRevive(Player* player);
+    [[nodiscard]] uint32 getGearValidationStamp(Player* player) const;
+    [[nodiscard]] bool gearValidatedForLogin(Player* player, bool notLoading) const;
+    static void resetGearValidationCache();
     [[nodiscard]] const std::unordered_map<uint8, uint32> *getTitleMapForChallenge(ChallengeModeSettings setting) const;
     [[nodiscard]] const std::unordered_map<uint8, uint32> *getTalentMapForChallenge(ChallengeModeSettings setting) const;
     [[nodiscard]] const std::unordered_map<uint8, uint32> *getItemMapForChallenge(ChallengeModeSettings setting) const;
     [[nodiscard]] const std::unordered_map<uint8, uint32> *getAchievementMapForChallenge(ChallengeModeSettings setting) const;
     [[nodiscard]] uint32 getItemRewardAmount(ChallengeModeSettings setting) const;
+    // Level at which characters choose their challenges, rewards start at the level after it
+    [[nodiscard]] static uint8 getEnrollLevel(uint8 playerClass) { return playerClass == CLASS_DEATH_KNIGHT ? 55 : 1; }
+    [[nodiscard]] static char const* getChallengeName(ChallengeModeSettings setting);
+    [[nodiscard]] static bool getChallengeByName(std::string_view name, ChallengeModeSettings& setting);
+    [[nodiscard]] static bool settingEnabledInData(std::string_view data, uint8 settingIndex);
+    [[nodiscard]] static std::string getLogsPath(std::string const& fileName);
+    // SQL expressions over one setting index of character_settings.data, the settings table must be aliased as s
+    [[nodiscard]] static std::string settingValueSql(uint8 settingIndex);
+    [[nodiscard]] static std::string settingEnabledSql(uint8 settingIndex);
+    // The new data of the row with one setting changed, data can be another setSettingSql to change several settings
+    [[nodiscard]] static std::string setSettingSql(uint8 settingIndex, uint32 value, std::string const& data = "s.data");
 };
 
 #define sChallengeModes ChallengeModes::instance()
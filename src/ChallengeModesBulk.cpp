@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesBulk.h"
+#include "ChallengeModesLeaderboard.h"
+#include "Chat.h"
+#include "GameTime.h"
+#include "ObjectAccessor.h"
+#include <algorithm>
+#include <unordered_set>
+
+ChallengeModeBulk* ChallengeModeBulk::instance()
+{
+    static ChallengeModeBulk instance;
+    return &instance;
+}
+
+void ChallengeModeBulk::Run(ChallengeModeBulkUpdate update)
+{
+    std::string query = Acore::StringFormat("SELECT s.guid, c.online FROM character_settings s JOIN characters c ON c.guid = s.guid "
+        "WHERE s.source = 'mod-challenge-modes' AND {}", update.condition);
+    _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery(query).WithCallback([this, update = std::move(update)](QueryResult result)
+    {
+        Apply(update, result);
+    }));
+}
+
+void ChallengeModeBulk::Apply(ChallengeModeBulkUpdate const& update, QueryResult result)
+{
+    std::unordered_set<ObjectGuid::LowType> selected;
+    std::string offlineGuids;
+    uint64 offlineCount = 0;
+    if (result)
+    {
+        do
+        {
+            Field* fields = result->Fetch();
+            ObjectGuid::LowType guid = fields[0].Get<uint32>();
+            selected.insert(guid);
+            if (fields[1].Get<uint8>())
+            {
+                continue;
+            }
+            if (!offlineGuids.empty())
+            {
+                offlineGuids += ',';
+            }
+            offlineGuids += std::to_string(guid);
+            ++offlineCount;
+        } while (result->NextRow());
+    }
+
+    // Characters that logged in or out since the select are matched by their state in memory, and skipped by the condition of the update
+    std::vector<Player*> onlinePlayers;
+    for (auto const& [guid, player] : ObjectAccessor::GetPlayers())
+    {
+        if (update.matchesOnline(player, selected.count(guid.GetCounter()) > 0))
+        {
+            onlinePlayers.push_back(player);
+        }
+    }
+
+    if (!update.apply)
+    {
+        Report(update.issuer, Acore::StringFormat("将更新 {} 个离线角色和 {} 个在线角色。在命令末尾加上 apply 以执行。", offlineCount, onlinePlayers.size()));
+        return;
+    }
+
+    for (Player* player : onlinePlayers)
+    {
+        update.updateOnline(player);
+        sChallengeModeLeaderboard->UpdatePlayer(player);
+    }
+    size_t onlineCount = onlinePlayers.size();
+    if (offlineGuids.empty())
+    {
+        Report(update.issuer, Acore::StringFormat("已更新 0 个离线角色和 {} 个在线角色。", onlineCount));
+        return;
+    }
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    trans->Append(Acore::StringFormat("UPDATE character_settings s JOIN characters c ON c.guid = s.guid SET s.data = {} "
+        "WHERE s.source = 'mod-challenge-modes' AND c.online = 0 AND s.guid IN ({}) AND {}", update.newData, offlineGuids, update.condition));
+    _transactionProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([this, offlineGuids, appliedCondition = update.appliedCondition, issuer = update.issuer, onlineCount](bool success)
+    {
+        if (!success)
+        {
+            LOG_ERROR("mod-challenge-modes", "Failed to commit a challenge bulk update of offline characters.");
+            Report(issuer, Acore::StringFormat("离线角色更新失败，已更新 {} 个在线角色。", onlineCount));
+            return;
+        }
+        _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery(Acore::StringFormat("SELECT COUNT(*) FROM character_settings s "
+            "WHERE s.source = 'mod-challenge-modes' AND s.guid IN ({}) AND {}", offlineGuids, appliedCondition)).WithCallback([issuer, onlineCount](QueryResult result)
+        {
+            uint64 updated = result ? result->Fetch()[0].Get<uint64>() : 0;
+            Report(issuer, Acore::StringFormat("已更新 {} 个离线角色和 {} 个在线角色。", updated, onlineCount));
+            sChallengeModeLeaderboard->Load();
+        }));
+    });
+}
+
+void ChallengeModeBulk::Update()
+{
+    _queryProcessor.ProcessReadyCallbacks();
+    _transactionProcessor.ProcessReadyCallbacks();
+}
+
+uint32 ChallengeModeBulk::NextReviveStamp()
+{
+    _lastReviveStamp = std::max<uint32>(uint32(GameTime::GetGameTime().count()), _lastReviveStamp + 1);
+    return _lastReviveStamp;
+}
+
+void ChallengeModeBulk::Report(ObjectGuid issuer, std::string const& message)
+{
+    LOG_INFO("mod-challenge-modes", "{}", message);
+    if (Player* player = ObjectAccessor::FindConnectedPlayer(issuer))
+    {
+        ChatHandler(player->GetSession()).SendSysMessage(message);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_BULK_H
+#define AZEROTHCORE_CHALLENGEMODES_BULK_H
+
+#include "ChallengeModes.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <functional>
+
+struct ChallengeModeBulkUpdate
+{
+    std::string condition;        // Characters to update, over character_settings s joined with characters c
+    std::string newData;          // New character_settings.data, see ChallengeModes::setSettingSql
+    std::string appliedCondition; // Matches rows the update was applied to, used to count them after the commit
+    // Online characters are checked and updated in memory, their settings are written back on their next save.
+    // selected is set when the character matched the condition in the database.
+    std::function<bool(Player*, bool selected)> matchesOnline;
+    std::function<void(Player*)> updateOnline;
+    bool apply = false;
+    ObjectGuid issuer;
+};
+
+// Runs the .challenge bulk commands on the characters database without blocking the world thread.
+// The matching characters are selected asynchronously, the offline ones are updated in one transaction that checks the condition again,
+// and the updated rows are counted once it committed.
+class ChallengeModeBulk
+{
+public:
+    static ChallengeModeBulk* instance();
+
+    // World thread only
+    void Run(ChallengeModeBulkUpdate update);
+    void Update();
+    // Unique per bulk revive, written to HARDCORE_REVIVED so the revived rows can be counted
+    uint32 NextReviveStamp();
+
+private:
+    void Apply(ChallengeModeBulkUpdate const& update, QueryResult result);
+    static void Report(ObjectGuid issuer, std::string const& message);
+
+    QueryCallbackProcessor _queryProcessor;
+    AsyncCallbackProcessor<TransactionCallback> _transactionProcessor;
+    uint32 _lastReviveStamp = 0;
+};
+
+#define sChallengeModeBulk ChallengeModeBulk::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_BULK_H
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModes.h"
+#include "ChallengeModesBulk.h"
+#include "ChallengeModesJournal.h"
+#include "ChallengeModesRewards.h"
+
+using namespace Acore::ChatCommands;
+
+class cs_challenge_modes : public CommandScript
+{
+public:
+    cs_challenge_modes() : CommandScript("cs_challenge_modes") { }
+
+    ChatCommandTable GetCommands() const override
+    {
+        static ChatCommandTable backfillCommandTable =
+        {
+            { "start",  HandleBackfillStartCommand,  SEC_ADMINISTRATOR, Console::Yes },
+            { "status", HandleBackfillStatusCommand, SEC_ADMINISTRATOR, Console::Yes },
+            { "stop",   HandleBackfillStopCommand,   SEC_ADMINISTRATOR, Console::Yes }
+        };
+        static ChatCommandTable bulkCommandTable =
+        {
+            { "revive",  HandleBulkReviveCommand,  SEC_ADMINISTRATOR, Console::Yes },
+            { "disable", HandleBulkDisableCommand, SEC_ADMINISTRATOR, Console::Yes }
+        };
+        static ChatCommandTable challengeCommandTable =
+        {
+            { "backfill", backfillCommandTable },
+            { "bulk",     bulkCommandTable },
+            { "journal",  HandleJournalCommand, SEC_GAMEMASTER, Console::Yes }
+        };
+        static ChatCommandTable commandTable =
+        {
+            { "challenge", challengeCommandTable }
+        };
+        return commandTable;
+    }
+
+    static bool HandleBackfillStartCommand(ChatHandler* handler, std::string_view modeName, Optional<std::string_view> rewardTypeName)
+    {
+        if (!sChallengeModes->enabled())
+        {
+            handler->SendSysMessage("挑战模式未启用。");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        ChallengeModeSettings setting;
+        if (!ChallengeModes::getChallengeByName(modeName, setting))
+        {
+            handler->SendSysMessage(Acore::StringFormat("未知的挑战模式: {}", modeName));
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        int8 rewardType = -1;
+        if (rewardTypeName)
+        {
+            if (StringEqualI(*rewardTypeName, "title"))
+                rewardType = REWARD_TYPE_TITLE;
+            else if (StringEqualI(*rewardTypeName, "talent"))
+                rewardType = REWARD_TYPE_TALENT;
+            else if (StringEqualI(*rewardTypeName, "item"))
+                rewardType = REWARD_TYPE_ITEM;
+            else if (StringEqualI(*rewardTypeName, "achievement"))
+                rewardType = REWARD_TYPE_ACHIEVEMENT;
+            else
+            {
+                handler->SendSysMessage("奖励类型必须是 title, talent, item 或 achievement。");
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+        }
+
+        ObjectGuid issuer = handler->GetSession() ? handler->GetSession()->GetPlayer()->GetGUID() : ObjectGuid::Empty;
+        if (!sChallengeModeRewards->StartBackfill(setting, rewardType, issuer))
+        {
+            handler->SendSysMessage("已有奖励回填任务正在运行。");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+        handler->SendSysMessage(Acore::StringFormat("{} 奖励回填已开始。", ChallengeModes::getChallengeName(setting)));
+        return true;
+    }
+
+    static bool HandleBackfillStatusCommand(ChatHandler* handler)
+    {
+        ChallengeModeBackfill const& backfill = sChallengeModeRewards->GetBackfill();
+        handler->SendSysMessage(Acore::StringFormat("{} 奖励回填{}: 角色 GUID {}, 已检查 {} 个角色, 已排队 {} 项奖励。",
+            ChallengeModes::getChallengeName(backfill.mode), backfill.running ? "运行中" : "未运行", backfill.lastGuid, backfill.characters, backfill.rewards));
+        return true;
+    }
+
+    static bool HandleBackfillStopCommand(ChatHandler* handler)
+    {
+        sChallengeModeRewards->StopBackfill();
+        handler->SendSysMessage("奖励回填已停止。");
+        return true;
+    }
+
+    static bool HandleJournalCommand(ChatHandler* handler, Optional<PlayerIdentifier> player, Optional<uint32> count)
+    {
+        if (!player)
+        {
+            player = PlayerIdentifier::FromTargetOrSelf(handler);
+        }
+        if (!player)
+        {
+            handler->SendSysMessage(LANG_PLAYER_NOT_FOUND);
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+        if (!sChallengeModeJournal->IsOpen())
+        {
+            handler->SendSysMessage("挑战日志未启用。");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        std::vector<ChallengeJournalRecord> records = sChallengeModeJournal->GetRecords(player->GetGUID().GetCounter(), count.value_or(20));
+        handler->SendSysMessage(Acore::StringFormat("{} 的挑战日志 ({} 条记录):", player->GetName(), records.size()));
+        for (ChallengeJournalRecord const& record : records)
+        {
+            handler->SendSysMessage(Acore::StringFormat("#{} {} {} lvl {} {} {} {} {}",
+                record.sequence, record.time, challengeJournalEventName(record.event), record.level,
+                record.mode == CHALLENGE_JOURNAL_NO_MODE ? "-" : ChallengeModes::getChallengeName(ChallengeModeSettings(record.mode)),
+                record.value1, record.value2, record.value3));
+        }
+        return true;
+    }
+
+    // Revives every hardcore character that died between two unix times, for example during an outage.
+    // Online characters are resurrected right away, offline ones are marked and resurrected at their next login.
+    static bool HandleBulkReviveCommand(ChatHandler* handler, uint32 fromTime, uint32 toTime, Optional<std::string_view> confirm)
+    {
+        ChallengeModeBulkUpdate update;
+        update.apply = confirm && StringEqualI(*confirm, "apply");
+        update.issuer = handler->GetSession() ? handler->GetSession()->GetPlayer()->GetGUID() : ObjectGuid::Empty;
+        update.condition = Acore::StringFormat("{} AND s.guid IN (SELECT d.guid FROM challenge_mode_deaths d WHERE d.died BETWEEN FROM_UNIXTIME({}) AND FROM_UNIXTIME({}))",
+            ChallengeModes::settingEnabledSql(HARDCORE_DEAD), fromTime, toTime);
+        // The stamp tells the revived rows apart, so they can be counted and the login of the character knows it was revived by a GM
+        uint32 stamp = sChallengeModeBulk->NextReviveStamp();
+        update.newData = ChallengeModes::setSettingSql(HARDCORE_DEAD, 0, ChallengeModes::setSettingSql(HARDCORE_REVIVED, stamp));
+        update.appliedCondition = Acore::StringFormat("{} = '{}'", ChallengeModes::settingValueSql(HARDCORE_REVIVED), stamp);
+        update.matchesOnline = [](Player* player, bool selected)
+        {
+            return selected && ChallengeModes::getPlayerSettings(player).IsSet(HARDCORE_DEAD);
+        };
+        update.updateOnline = [](Player* player)
+        {
+            ChallengeModes::reviveHardcorePlayer(player);
+        };
+        sChallengeModeBulk->Run(std::move(update));
+        handler->SendSysMessage("正在查找角色...");
+        return true;
+    }
+
+    // Turns a challenge off for every character below a level
+    static bool HandleBulkDisableCommand(ChatHandler* handler, std::string_view modeName, uint8 belowLevel, Optional<std::string_view> confirm)
+    {
+        ChallengeModeSettings setting;
+        if (!ChallengeModes::getChallengeByName(modeName, setting))
+        {
+            handler->SendSysMessage(Acore::StringFormat("未知的挑战模式: {}", modeName));
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        ChallengeModeBulkUpdate update;
+        update.apply = confirm && StringEqualI(*confirm, "apply");
+        update.issuer = handler->GetSession() ? handler->GetSession()->GetPlayer()->GetGUID() : ObjectGuid::Empty;
+        update.condition = Acore::StringFormat("c.level < {} AND {}", belowLevel, ChallengeModes::settingEnabledSql(setting));
+        update.newData = ChallengeModes::setSettingSql(setting, 0);
+        update.appliedCondition = Acore::StringFormat("NOT {}", ChallengeModes::settingEnabledSql(setting));
+        // The level and settings saved in the database lag behind online characters, so these are matched in memory only
+        update.matchesOnline = [setting, belowLevel](Player* player, bool /*selected*/)
+        {
+            return player->GetLevel() < belowLevel && ChallengeModes::getPlayerSettings(player).IsSet(setting);
+        };
+        update.updateOnline = [setting](Player* player)
+        {
+            ChallengeModes::setPlayerSetting(player, setting, 0);
+        };
+        sChallengeModeBulk->Run(std::move(update));
+        handler->SendSysMessage("正在查找角色...");
+        return true;
+    }
+};
+
+void AddSC_mod_challenge_modes_commands()
+{
+    new cs_challenge_modes();
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesDeaths.h"
+#include "GameTime.h"
+#include "ObjectAccessor.h"
+#include <algorithm>
+
+ChallengeModeDeaths* ChallengeModeDeaths::instance()
+{
+    static ChallengeModeDeaths instance;
+    return &instance;
+}
+
+void ChallengeModeDeaths::QueueDeath(Player* player)
+{
+    // Only used when the character was never saved with a challenge enabled and has no settings row yet
+    std::string settings;
+    for (uint8 i = 0; i < MAX_CHALLENGE_MODE_SETTING; ++i)
+    {
+        if (i)
+        {
+            settings.push_back(' ');
+        }
+        settings += std::to_string(ChallengeModes::getPlayerSettings(player).Get(i));
+    }
+
+    ChallengeModeDeath death{ std::move(settings), uint32(GameTime::GetGameTime().count()), player->GetLevel() };
+    std::lock_guard<std::mutex> guard(_queueLock);
+    _queuedDeaths.emplace(player->GetGUID().GetCounter(), std::move(death));
+}
+
+void ChallengeModeDeaths::QueueKick(Player* player)
+{
+    ObjectGuid::LowType guid = player->GetGUID().GetCounter();
+    std::lock_guard<std::mutex> guard(_queueLock);
+    if (_kickGuids.insert(guid).second)
+    {
+        _queuedKicks.push_back(guid);
+    }
+}
+
+void ChallengeModeDeaths::CancelDeath(ObjectGuid::LowType guid)
+{
+    std::lock_guard<std::mutex> guard(_queueLock);
+    _queuedDeaths.erase(guid);
+    if (_inFlightGuids.count(guid))
+    {
+        _cancelledGuids.insert(guid);
+    }
+    if (_kickGuids.erase(guid))
+    {
+        _queuedKicks.erase(std::find(_queuedKicks.begin(), _queuedKicks.end(), guid));
+    }
+}
+
+CharacterDatabaseTransaction ChallengeModeDeaths::BuildTransaction(DeathMap const& deaths)
+{
+    std::string settingRows;
+    std::string deathRows;
+    std::string guidList;
+    for (auto const& [guid, death] : deaths)
+    {
+        if (!settingRows.empty())
+        {
+            settingRows += ", ";
+            deathRows += ", ";
+            guidList += ',';
+        }
+        settingRows += Acore::StringFormat("({}, '{}', '{}')", guid, challengeModeSettingSource, death.settings);
+        deathRows += Acore::StringFormat("({}, {}, FROM_UNIXTIME({}))", guid, death.level, death.died);
+        guidList += std::to_string(guid);
+    }
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    trans->Append(Acore::StringFormat("INSERT IGNORE INTO character_settings (guid, source, data) VALUES {}", settingRows));
+    // Settings changed after the death was queued may already be saved, so existing rows only get the dead flag
+    trans->Append(Acore::StringFormat("UPDATE character_settings s SET s.data = {} WHERE s.source = '{}' AND s.guid IN ({})",
+        ChallengeModes::setSettingSql(HARDCORE_DEAD, 1), challengeModeSettingSource, guidList));
+    // The time of death lets GMs revive everyone who died in a given window with .challenge bulk revive
+    trans->Append(Acore::StringFormat("INSERT INTO challenge_mode_deaths (guid, level, died) VALUES {}", deathRows));
+    return trans;
+}
+
+CharacterDatabaseTransaction ChallengeModeDeaths::BuildCancelTransaction(DeathMap const& deaths)
+{
+    std::string guidList;
+    std::string deathRows;
+    for (auto const& [guid, death] : deaths)
+    {
+        if (!guidList.empty())
+        {
+            guidList += ',';
+            deathRows += " OR ";
+        }
+        guidList += std::to_string(guid);
+        deathRows += Acore::StringFormat("(guid = {} AND died = FROM_UNIXTIME({}))", guid, death.died);
+    }
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    trans->Append(Acore::StringFormat("UPDATE character_settings s SET s.data = {} WHERE s.source = '{}' AND s.guid IN ({})",
+        ChallengeModes::setSettingSql(HARDCORE_DEAD, 0), challengeModeSettingSource, guidList));
+    trans->Append(Acore::StringFormat("DELETE FROM challenge_mode_deaths WHERE {}", deathRows));
+    return trans;
+}
+
+void ChallengeModeDeaths::Update()
+{
+    _transactionProcessor.ProcessReadyCallbacks();
+    KickPlayers();
+
+    // Deaths queued while a commit is in flight are coalesced into the next one
+    if (_commitInFlight)
+    {
+        return;
+    }
+
+    DeathMap deaths;
+    {
+        std::lock_guard<std::mutex> guard(_queueLock);
+        deaths.swap(_queuedDeaths);
+        for (auto const& [guid, death] : deaths)
+        {
+            _inFlightGuids.insert(guid);
+        }
+    }
+    if (deaths.empty())
+    {
+        return;
+    }
+
+    _commitInFlight = true;
+    _transactionProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(BuildTransaction(deaths))).AfterComplete([this, deaths](bool success)
+    {
+        DeathMap cancelled;
+        {
+            std::lock_guard<std::mutex> guard(_queueLock);
+            for (ObjectGuid::LowType guid : _cancelledGuids)
+            {
+                cancelled.emplace(guid, deaths.at(guid));
+            }
+            _inFlightGuids.clear();
+            _cancelledGuids.clear();
+            if (!success)
+            {
+                LOG_ERROR("mod-challenge-modes", "Failed to persist {} hardcore deaths, retrying.", deaths.size() - cancelled.size());
+                // Revived characters are dropped, deaths of the same characters queued meanwhile are newer and are kept
+                for (auto const& [guid, death] : deaths)
+                {
+                    if (!cancelled.count(guid))
+                    {
+                        _queuedDeaths.emplace(guid, death);
+                    }
+                }
+            }
+        }
+        if (!success || cancelled.empty())
+        {
+            _commitInFlight = false;
+            return;
+        }
+
+        // The next batch waits for the undo, so a character that died again after the revive keeps its new death
+        _transactionProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(BuildCancelTransaction(cancelled))).AfterComplete([this, cancelled](bool undone)
+        {
+            _commitInFlight = false;
+            if (!undone)
+            {
+                LOG_ERROR("mod-challenge-modes", "Failed to undo the deaths of {} revived hardcore characters.", cancelled.size());
+            }
+        });
+    });
+}
+
+void ChallengeModeDeaths::KickPlayers()
+{
+    std::vector<ObjectGuid::LowType> guids;
+    {
+        std::lock_guard<std::mutex> guard(_queueLock);
+        while (!_queuedKicks.empty() && guids.size() < sChallengeModes->deathKicksPerUpdate)
+        {
+            guids.push_back(_queuedKicks.front());
+            _kickGuids.erase(_queuedKicks.front());
+            _queuedKicks.pop_front();
+        }
+    }
+
+    // Characters that logged out meanwhile were already saved with the dead flag set
+    for (ObjectGuid::LowType guid : guids)
+    {
+        if (Player* player = ObjectAccessor::FindPlayerByLowGUID(guid))
+        {
+            player->GetSession()->KickPlayer(std::string("极限模式角色已死亡"));
+        }
+    }
+}
+
+void ChallengeModeDeaths::Flush()
+{
+    DeathMap deaths;
+    {
+        std::lock_guard<std::mutex> guard(_queueLock);
+        deaths.swap(_queuedDeaths);
+        _queuedKicks.clear();
+        _kickGuids.clear();
+    }
+    if (!deaths.empty())
+    {
+        CharacterDatabase.DirectCommitTransaction(BuildTransaction(deaths));
+    }
+}
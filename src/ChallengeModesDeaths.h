@@ -0,0 +1,59 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_DEATHS_H
+#define AZEROTHCORE_CHALLENGEMODES_DEATHS_H
+
+#include "ChallengeModes.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+struct ChallengeModeDeath
+{
+    std::string settings; // character_settings.data of the challenge source at the time of death, written when the character has no settings row yet
+    uint32 died;          // unix time
+    uint8 level;
+};
+
+// Hardcore deaths are finalized by the world thread. Deaths queued since the last update are persisted in one transaction,
+// and kicks, each followed by a full character save, are spread over world updates with a per-update budget.
+class ChallengeModeDeaths
+{
+public:
+    static ChallengeModeDeaths* instance();
+
+    // Thread safe, may be called from map update threads
+    void QueueDeath(Player* player);
+    void QueueKick(Player* player);
+    // Drops the queued death and kick of a character revived by a GM
+    void CancelDeath(ObjectGuid::LowType guid);
+
+    // World thread only
+    void Update();
+    // Persists every queued death synchronously, called at shutdown
+    void Flush();
+
+private:
+    using DeathMap = std::unordered_map<ObjectGuid::LowType, ChallengeModeDeath>;
+
+    static CharacterDatabaseTransaction BuildTransaction(DeathMap const& deaths);
+    // Undoes the committed deaths of characters revived while their commit was in flight
+    static CharacterDatabaseTransaction BuildCancelTransaction(DeathMap const& deaths);
+    void KickPlayers();
+
+    std::mutex _queueLock;
+    DeathMap _queuedDeaths;
+    std::deque<ObjectGuid::LowType> _queuedKicks;
+    std::unordered_set<ObjectGuid::LowType> _kickGuids;
+    // Deaths of the commit in flight, and those of them cancelled by a revive before it completed
+    std::unordered_set<ObjectGuid::LowType> _inFlightGuids;
+    std::unordered_set<ObjectGuid::LowType> _cancelledGuids;
+
+    AsyncCallbackProcessor<TransactionCallback> _transactionProcessor;
+    bool _commitInFlight = false;
+};
+
+#define sChallengeModeDeaths ChallengeModeDeaths::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_DEATHS_H
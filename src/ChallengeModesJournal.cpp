@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesJournal.h"
+#include "GameTime.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <boost/interprocess/file_mapping.hpp>
+
+ChallengeModeJournal* ChallengeModeJournal::instance()
+{
+    static ChallengeModeJournal instance;
+    return &instance;
+}
+
+// An existing journal is reused only when it was written with the same layout and capacity
+static bool IsCompatibleJournal(std::string const& fileName, uint32 capacity, std::size_t size)
+{
+    std::error_code error;
+    if (std::filesystem::file_size(fileName, error) != size)
+    {
+        return false;
+    }
+    ChallengeJournalHeader header = {};
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    // A journal that was created but never written to is empty
+    if (!header.magic)
+    {
+        return true;
+    }
+    return header.magic == CHALLENGE_JOURNAL_MAGIC && header.version == CHALLENGE_JOURNAL_VERSION &&
+        header.recordSize == sizeof(ChallengeJournalRecord) && header.capacity == capacity;
+}
+
+bool ChallengeModeJournal::Open(std::string const& fileName, uint32 capacity)
+{
+    Close();
+    if (!capacity)
+    {
+        return false;
+    }
+
+    std::size_t size = sizeof(ChallengeJournalHeader) + std::size_t(capacity) * sizeof(ChallengeJournalRecord);
+    try
+    {
+        std::error_code error;
+        if (std::filesystem::exists(fileName, error) && !IsCompatibleJournal(fileName, capacity, size))
+        {
+            // Keep the old records for disputes, the decoder reads the rotated file like any other journal
+            std::string rotatedName = fileName + "." + std::to_string(GameTime::GetGameTime().count());
+            std::filesystem::rename(fileName, rotatedName);
+            LOG_INFO("mod-challenge-modes", "Challenge journal {} does not match the capacity of {} records, moved it to {}.", fileName, capacity, rotatedName);
+        }
+        if (!std::filesystem::exists(fileName, error))
+        {
+            LOG_INFO("mod-challenge-modes", "Creating challenge journal {} with {} records.", fileName, capacity);
+            std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+            file.close();
+            std::filesystem::resize_file(fileName, size);
+        }
+        boost::interprocess::file_mapping mapping(fileName.c_str(), boost::interprocess::read_write);
+        _region = std::make_unique<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_write, 0, size);
+    }
+    catch (std::exception const& e)
+    {
+        LOG_ERROR("mod-challenge-modes", "Failed to open challenge journal {}: {}", fileName, e.what());
+        _region.reset();
+        return false;
+    }
+
+    _header = static_cast<ChallengeJournalHeader*>(_region->get_address());
+    _records = reinterpret_cast<ChallengeJournalRecord*>(_header + 1);
+    _capacity = capacity;
+
+    if (_header->magic != CHALLENGE_JOURNAL_MAGIC || _header->version != CHALLENGE_JOURNAL_VERSION ||
+        _header->recordSize != sizeof(ChallengeJournalRecord) || _header->capacity != capacity)
+    {
+        std::memset(_region->get_address(), 0, size);
+        _header->magic = CHALLENGE_JOURNAL_MAGIC;
+        _header->version = CHALLENGE_JOURNAL_VERSION;
+        _header->recordSize = sizeof(ChallengeJournalRecord);
+        _header->capacity = capacity;
+        _header->nextSequence = 1;
+    }
+
+    // The header is only updated on close, so resume after the newest record in case the server crashed
+    uint64 nextSequence = std::max<uint64>(_header->nextSequence, 1);
+    for (uint32 i = 0; i < capacity; ++i)
+    {
+        nextSequence = std::max<uint64>(nextSequence, _records[i].sequence + 1);
+    }
+    _nextSequence = nextSequence;
+    return true;
+}
+
+void ChallengeModeJournal::Close()
+{
+    if (!_region)
+    {
+        return;
+    }
+    _header->nextSequence = _nextSequence;
+    _region->flush();
+    _region.reset();
+    _header = nullptr;
+    _records = nullptr;
+    _capacity = 0;
+}
+
+void ChallengeModeJournal::Record(ChallengeJournalEvent event, Player* player, uint8 mode, uint32 value1, uint32 value2, uint32 value3)
+{
+    if (!_records)
+    {
+        return;
+    }
+
+    uint64 sequence = _nextSequence.fetch_add(1, std::memory_order_relaxed);
+    ChallengeJournalRecord& record = _records[sequence % _capacity];
+    // Clear the sequence first so a record torn by a crash reads as an empty slot
+    record.sequence = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    record.time = uint32(GameTime::GetGameTime().count());
+    record.guid = player->GetGUID().GetCounter();
+    record.event = event;
+    record.mode = mode;
+    record.level = player->GetLevel();
+    record.reserved = 0;
+    record.value1 = value1;
+    record.value2 = value2;
+    record.value3 = value3;
+    std::atomic_thread_fence(std::memory_order_release);
+    record.sequence = sequence;
+}
+
+std::vector<ChallengeJournalRecord> ChallengeModeJournal::GetRecords(ObjectGuid::LowType guid, uint32 count) const
+{
+    std::vector<ChallengeJournalRecord> records;
+    if (!_records)
+    {
+        return records;
+    }
+
+    for (uint32 i = 0; i < _capacity; ++i)
+    {
+        if (_records[i].sequence && _records[i].guid == guid)
+        {
+            records.push_back(_records[i]);
+        }
+    }
+    std::sort(records.begin(), records.end(), [](ChallengeJournalRecord const& left, ChallengeJournalRecord const& right)
+    {
+        return left.sequence < right.sequence;
+    });
+    if (records.size() > count)
+    {
+        records.erase(records.begin(), records.end() - count);
+    }
+    return records;
+}
+
+class ChallengeModes_JournalScript : public PlayerScript
+{
+public:
+    ChallengeModes_JournalScript() : PlayerScript("ChallengeModes_JournalScript") { }
+
+    static void RecordCharacterEvent(ChallengeJournalEvent event, Player* player, uint32 value1 = 0)
+    {
+        if (!sChallengeModeJournal->IsOpen())
+        {
+            return;
+        }
+        uint32 challengeMask = ChallengeModes::getPlayerChallengeMask(player);
+        if (!challengeMask)
+        {
+            return;
+        }
+        sChallengeModeJournal->Record(event, player, CHALLENGE_JOURNAL_NO_MODE, value1, challengeMask, ChallengeModes::getPlayerSettings(player).Get(HARDCORE_DEAD));
+    }
+
+    void OnPlayerLevelChanged(Player* player, uint8 oldlevel) override
+    {
+        RecordCharacterEvent(JOURNAL_EVENT_LEVEL_CHANGED, player, oldlevel);
+    }
+
+    void OnPlayerKilledByCreature(Creature* killer, Player* killed) override
+    {
+        RecordCharacterEvent(JOURNAL_EVENT_KILLED_BY_CREATURE, killed, killer ? killer->GetEntry() : 0);
+    }
+
+    void OnPlayerPVPKill(Player* killer, Player* killed) override
+    {
+        RecordCharacterEvent(JOURNAL_EVENT_KILLED_BY_PLAYER, killed, killer ? killer->GetGUID().GetCounter() : 0);
+    }
+
+    void OnPlayerResurrect(Player* player, float /*restore_percent*/, bool /*applySickness*/) override
+    {
+        RecordCharacterEvent(JOURNAL_EVENT_RESURRECT, player);
+    }
+
+    void OnPlayerReleasedGhost(Player* player) override
+    {
+        RecordCharacterEvent(JOURNAL_EVENT_RELEASED_GHOST, player);
+    }
+};
+
+void AddSC_mod_challenge_modes_journal()
+{
+    new ChallengeModes_JournalScript();
+}
@@ -0,0 +1,38 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_JOURNAL_H
+#define AZEROTHCORE_CHALLENGEMODES_JOURNAL_H
+
+#include "ChallengeModes.h"
+#include "ChallengeModesJournalFormat.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <boost/interprocess/mapped_region.hpp>
+
+// Append-only journal of challenge relevant events, written through a memory-mapped ring file.
+// Recording an event takes a slot with one atomic increment and never allocates.
+class ChallengeModeJournal
+{
+public:
+    static ChallengeModeJournal* instance();
+
+    bool Open(std::string const& fileName, uint32 capacity);
+    void Close();
+    [[nodiscard]] bool IsOpen() const { return _records != nullptr; }
+
+    // Thread safe, may be called from map update threads
+    void Record(ChallengeJournalEvent event, Player* player, uint8 mode, uint32 value1 = 0, uint32 value2 = 0, uint32 value3 = 0);
+
+    // Returns the newest records of a character, oldest first
+    [[nodiscard]] std::vector<ChallengeJournalRecord> GetRecords(ObjectGuid::LowType guid, uint32 count) const;
+
+private:
+    std::unique_ptr<boost::interprocess::mapped_region> _region;
+    ChallengeJournalHeader* _header = nullptr;
+    ChallengeJournalRecord* _records = nullptr;
+    uint32 _capacity = 0;
+    std::atomic<uint64> _nextSequence{ 1 };
+};
+
+#define sChallengeModeJournal ChallengeModeJournal::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_JOURNAL_H
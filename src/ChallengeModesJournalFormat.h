@@ -0,0 +1,84 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_JOURNAL_FORMAT_H
+#define AZEROTHCORE_CHALLENGEMODES_JOURNAL_FORMAT_H
+
+// On-disk layout of the challenge event journal, shared with tools/challenge_journal_decode.cpp.
+// Only standard headers may be included here so the decoder builds without the core.
+#include <cstdint>
+
+constexpr uint32_t CHALLENGE_JOURNAL_MAGIC   = 0x4A4D4843; // "CHMJ"
+constexpr uint32_t CHALLENGE_JOURNAL_VERSION = 1;
+constexpr uint8_t  CHALLENGE_JOURNAL_NO_MODE = 0xFF;
+
+enum ChallengeJournalEvent : uint8_t
+{
+    JOURNAL_EVENT_NONE               = 0,
+    JOURNAL_EVENT_XP_GAIN            = 1, // value1 = XP after multiplier, value2 = 16.16 multiplier, value3 = XP source
+    // Character events store the challenge mask in value2 and the hardcore dead flag in value3
+    JOURNAL_EVENT_LEVEL_CHANGED      = 2, // value1 = old level
+    JOURNAL_EVENT_KILLED_BY_CREATURE = 3, // value1 = creature entry
+    JOURNAL_EVENT_KILLED_BY_PLAYER   = 4, // value1 = killer guid
+    JOURNAL_EVENT_RESURRECT          = 5,
+    JOURNAL_EVENT_RELEASED_GHOST     = 6,
+    JOURNAL_EVENT_EQUIP_BLOCKED      = 7, // value1 = item entry
+    JOURNAL_EVENT_USE_BLOCKED        = 8, // value1 = item entry
+    JOURNAL_EVENT_SPEEDRUN_FAILED    = 9, // value1 = played time in seconds
+    MAX_JOURNAL_EVENT
+};
+
+// The file is a header followed by a ring of fixed-size records, record N lives in slot N % capacity
+struct ChallengeJournalHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint64_t nextSequence;
+    uint8_t  reserved[40];
+};
+
+struct ChallengeJournalRecord
+{
+    uint64_t sequence;   // 0 marks an empty slot, sequences start at 1
+    uint32_t time;       // unix time
+    uint32_t guid;       // character guid
+    uint8_t  event;      // ChallengeJournalEvent
+    uint8_t  mode;       // ChallengeModeSettings or CHALLENGE_JOURNAL_NO_MODE
+    uint8_t  level;
+    uint8_t  reserved;
+    uint32_t value1;
+    uint32_t value2;
+    uint32_t value3;
+};
+
+static_assert(sizeof(ChallengeJournalHeader) == 64, "Journal header layout changed");
+static_assert(sizeof(ChallengeJournalRecord) == 32, "Journal record layout changed");
+
+constexpr char const* challengeJournalEventName(uint8_t event)
+{
+    switch (event)
+    {
+        case JOURNAL_EVENT_XP_GAIN:
+            return "XP_GAIN";
+        case JOURNAL_EVENT_LEVEL_CHANGED:
+            return "LEVEL_CHANGED";
+        case JOURNAL_EVENT_KILLED_BY_CREATURE:
+            return "KILLED_BY_CREATURE";
+        case JOURNAL_EVENT_KILLED_BY_PLAYER:
+            return "KILLED_BY_PLAYER";
+        case JOURNAL_EVENT_RESURRECT:
+            return "RESURRECT";
+        case JOURNAL_EVENT_RELEASED_GHOST:
+            return "RELEASED_GHOST";
+        case JOURNAL_EVENT_EQUIP_BLOCKED:
+            return "EQUIP_BLOCKED";
+        case JOURNAL_EVENT_USE_BLOCKED:
+            return "USE_BLOCKED";
+        case JOURNAL_EVENT_SPEEDRUN_FAILED:
+            return "SPEEDRUN_FAILED";
+        default:
+            break;
+    }
+    return "UNKNOWN";
+}
+
+#endif //AZEROTHCORE_CHALLENGEMODES_JOURNAL_FORMAT_H
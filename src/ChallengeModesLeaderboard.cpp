@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesLeaderboard.h"
+#include "GameTime.h"
+#include "ObjectAccessor.h"
+#include <cstdio>
+#include <fstream>
+
+ChallengeModeLeaderboard* ChallengeModeLeaderboard::instance()
+{
+    static ChallengeModeLeaderboard instance;
+    return &instance;
+}
+
+void ChallengeModeLeaderboard::Start()
+{
+    if (_running)
+    {
+        return;
+    }
+    _changesFile = ChallengeModes::getLogsPath(sChallengeModes->leaderboardFile);
+    _snapshotFile = ChallengeModes::getLogsPath(sChallengeModes->leaderboardSnapshotFile);
+    _stopping = false;
+    _running = true;
+    _writer = std::thread(&ChallengeModeLeaderboard::Run, this);
+    Load();
+}
+
+void ChallengeModeLeaderboard::Stop()
+{
+    if (!_running)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _wakeup.notify_one();
+    _writer.join();
+    _running = false;
+}
+
+void ChallengeModeLeaderboard::Load()
+{
+    if (!_running)
+    {
+        return;
+    }
+    _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery("SELECT c.guid, c.name, c.level, c.logout_time, s.data FROM characters c "
+        "JOIN character_settings s ON s.guid = c.guid AND s.source = 'mod-challenge-modes'").WithCallback([this](QueryResult result)
+    {
+        LoadStandings(result);
+    }));
+}
+
+void ChallengeModeLeaderboard::LoadStandings(QueryResult result)
+{
+    if (!result)
+    {
+        return;
+    }
+
+    // The standings are built without the lock, map threads only wait while they are swapped in
+    std::unordered_map<ObjectGuid::LowType, ChallengeModeStanding> standings;
+    standings.reserve(result->GetRowCount());
+    do
+    {
+        Field* fields = result->Fetch();
+        ObjectGuid::LowType guid = fields[0].Get<uint32>();
+        // Online characters may have changes that are not saved yet
+        if (ObjectAccessor::FindPlayerByLowGUID(guid))
+        {
+            continue;
+        }
+
+        std::string data = fields[4].Get<std::string>();
+        ChallengeModeStanding standing;
+        for (ChallengeModeSettings setting : challengeModeList)
+        {
+            if (ChallengeModes::settingEnabledInData(data, setting))
+            {
+                standing.mask |= challengeModeMask(setting);
+            }
+        }
+        standing.dead = ChallengeModes::settingEnabledInData(data, HARDCORE_DEAD);
+        standing.level = fields[2].Get<uint8>();
+        standing.lastChange = fields[3].Get<uint32>();
+        standing.name = fields[1].Get<std::string>();
+        standings.emplace(guid, std::move(standing));
+    } while (result->NextRow());
+
+    std::lock_guard<std::mutex> guard(_lock);
+    // Standings that were not loaded belong to online characters and are kept as they are
+    for (auto& [guid, current] : _standings)
+    {
+        auto itr = standings.find(guid);
+        if (itr == standings.end())
+        {
+            standings.emplace(guid, std::move(current));
+            continue;
+        }
+        ChallengeModeStanding& standing = itr->second;
+        if (standing.mask == current.mask && standing.level == current.level && standing.dead == current.dead)
+        {
+            standing = std::move(current);
+            continue;
+        }
+        standing.dirty = current.dirty;
+        MarkDirty(guid, standing);
+    }
+    for (auto itr = standings.begin(); itr != standings.end();)
+    {
+        ChallengeModeStanding& standing = itr->second;
+        if (standing.dirty || _standings.count(itr->first))
+        {
+            ++itr;
+        }
+        else if (!standing.mask && !standing.dead)
+        {
+            itr = standings.erase(itr);
+        }
+        else
+        {
+            MarkDirty(itr->first, standing);
+            ++itr;
+        }
+    }
+    _standings.swap(standings);
+}
+
+void ChallengeModeLeaderboard::Update()
+{
+    _queryProcessor.ProcessReadyCallbacks();
+}
+
+void ChallengeModeLeaderboard::UpdatePlayer(Player* player)
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    ChallengeModePlayerSettings const& settings = ChallengeModes::getPlayerSettings(player);
+    uint32 mask = settings.GetChallengeMask();
+    bool dead = settings.IsSet(HARDCORE_DEAD);
+    uint8 level = player->GetLevel();
+    ObjectGuid::LowType guid = player->GetGUID().GetCounter();
+
+    std::lock_guard<std::mutex> guard(_lock);
+    auto itr = _standings.find(guid);
+    if (itr == _standings.end())
+    {
+        if (!mask && !dead)
+        {
+            return;
+        }
+        itr = _standings.emplace(guid, ChallengeModeStanding()).first;
+    }
+    ChallengeModeStanding& standing = itr->second;
+    if (standing.mask == mask && standing.level == level && standing.dead == dead && standing.name == player->GetName())
+    {
+        return;
+    }
+    if (standing.name != player->GetName())
+    {
+        standing.name = player->GetName();
+    }
+    standing.mask = mask;
+    standing.level = level;
+    standing.dead = dead;
+    standing.lastChange = uint32(GameTime::GetGameTime().count());
+    MarkDirty(guid, standing);
+}
+
+void ChallengeModeLeaderboard::RemoveCharacter(ObjectGuid::LowType guid)
+{
+    if (!_running)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_standings.erase(guid))
+    {
+        _removed.push_back(guid);
+    }
+}
+
+void ChallengeModeLeaderboard::MarkDirty(ObjectGuid::LowType guid, ChallengeModeStanding& standing)
+{
+    if (!standing.dirty)
+    {
+        standing.dirty = true;
+        _dirty.push_back(guid);
+    }
+}
+
+void ChallengeModeLeaderboard::WriteStanding(std::ostream& stream, ObjectGuid::LowType guid, ChallengeModeStanding const& standing)
+{
+    // Character names can not contain quotes or backslashes, so they need no escaping
+    stream << "{\"guid\":" << guid << ",\"name\":\"" << standing.name << "\",\"mask\":" << standing.mask << ",\"level\":" << uint32(standing.level)
+        << ",\"dead\":" << (standing.dead ? "true" : "false") << ",\"changed\":" << standing.lastChange << "}\n";
+}
+
+void ChallengeModeLeaderboard::Run()
+{
+    std::vector<std::pair<ObjectGuid::LowType, ChallengeModeStanding>> changed;
+    std::vector<std::pair<ObjectGuid::LowType, ChallengeModeStanding>> snapshot;
+    std::vector<ObjectGuid::LowType> removed;
+    uint32 snapshotTimer = 0;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    while (true)
+    {
+        bool stopping = _wakeup.wait_for(lock, std::chrono::seconds(sChallengeModes->leaderboardInterval), [this] { return _stopping; });
+
+        // Copy the changes while holding the lock and write them without it, map threads only ever wait for the copy
+        changed.clear();
+        for (ObjectGuid::LowType guid : _dirty)
+        {
+            auto itr = _standings.find(guid);
+            if (itr != _standings.end())
+            {
+                itr->second.dirty = false;
+                changed.emplace_back(guid, itr->second);
+            }
+        }
+        _dirty.clear();
+        removed.swap(_removed);
+
+        snapshotTimer += sChallengeModes->leaderboardInterval;
+        bool writeSnapshot = stopping || snapshotTimer >= sChallengeModes->leaderboardSnapshotInterval;
+        if (writeSnapshot)
+        {
+            snapshotTimer = 0;
+            snapshot.assign(_standings.begin(), _standings.end());
+        }
+        lock.unlock();
+
+        if (!changed.empty() || !removed.empty())
+        {
+            std::ofstream changesFile(_changesFile, std::ios::app);
+            for (auto const& [guid, standing] : changed)
+            {
+                WriteStanding(changesFile, guid, standing);
+            }
+            for (ObjectGuid::LowType guid : removed)
+            {
+                changesFile << "{\"guid\":" << guid << ",\"deleted\":true}\n";
+            }
+            if (!changesFile)
+            {
+                LOG_ERROR("mod-challenge-modes", "Failed to write challenge leaderboard changes to {}.", _changesFile);
+            }
+        }
+        removed.clear();
+
+        // The snapshot holds every change written so far, so the changes file starts over after it
+        if (writeSnapshot)
+        {
+            std::string tempFile = _snapshotFile + ".tmp";
+            std::ofstream snapshotFile(tempFile, std::ios::trunc);
+            for (auto const& [guid, standing] : snapshot)
+            {
+                WriteStanding(snapshotFile, guid, standing);
+            }
+            snapshotFile.close();
+            if (!snapshotFile || std::rename(tempFile.c_str(), _snapshotFile.c_str()))
+            {
+                LOG_ERROR("mod-challenge-modes", "Failed to write challenge leaderboard snapshot to {}.", _snapshotFile);
+            }
+            else
+            {
+                std::ofstream(_changesFile, std::ios::trunc);
+            }
+            snapshot.clear();
+        }
+
+        lock.lock();
+        if (stopping)
+        {
+            break;
+        }
+    }
+}
+
+class ChallengeModes_LeaderboardScript : public PlayerScript
+{
+public:
+    ChallengeModes_LeaderboardScript() : PlayerScript("ChallengeModes_LeaderboardScript") { }
+
+    void OnPlayerLogin(Player* player) override
+    {
+        sChallengeModeLeaderboard->UpdatePlayer(player);
+    }
+
+    // Registered after the challenge scripts, so challenges disabled by DisableLevel are already reflected
+    void OnPlayerLevelChanged(Player* player, uint8 /*oldlevel*/) override
+    {
+        sChallengeModeLeaderboard->UpdatePlayer(player);
+    }
+
+    void OnPlayerDelete(ObjectGuid guid, uint32 /*accountId*/) override
+    {
+        sChallengeModeLeaderboard->RemoveCharacter(guid.GetCounter());
+    }
+};
+
+void AddSC_mod_challenge_modes_leaderboard()
+{
+    new ChallengeModes_LeaderboardScript();
+}
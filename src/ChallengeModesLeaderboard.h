@@ -0,0 +1,63 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_LEADERBOARD_H
+#define AZEROTHCORE_CHALLENGEMODES_LEADERBOARD_H
+
+#include "ChallengeModes.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ChallengeModeStanding
+{
+    std::string name;
+    uint32 mask = 0;       // Enabled challenges, see challengeModeMask
+    uint32 lastChange = 0; // unix time
+    uint8 level = 0;
+    bool dead = false;
+    bool dirty = false;
+};
+
+// In-memory standings of every enrolled character. A background thread appends changed standings to a JSON lines file
+// every few seconds and periodically replaces a full snapshot file, so websites can follow the file instead of the database.
+class ChallengeModeLeaderboard
+{
+public:
+    static ChallengeModeLeaderboard* instance();
+
+    // World thread only
+    void Start();
+    void Stop();
+    // Loads the standings of offline characters from the characters database, online characters keep their in-memory standing
+    void Load();
+    void Update();
+
+    // Thread safe, may be called from map update threads
+    void UpdatePlayer(Player* player);
+    void RemoveCharacter(ObjectGuid::LowType guid);
+
+private:
+    void Run();
+    void LoadStandings(QueryResult result);
+    void MarkDirty(ObjectGuid::LowType guid, ChallengeModeStanding& standing);
+    static void WriteStanding(std::ostream& stream, ObjectGuid::LowType guid, ChallengeModeStanding const& standing);
+
+    std::mutex _lock;
+    std::condition_variable _wakeup;
+    std::unordered_map<ObjectGuid::LowType, ChallengeModeStanding> _standings;
+    std::vector<ObjectGuid::LowType> _dirty;
+    std::vector<ObjectGuid::LowType> _removed;
+    std::thread _writer;
+    std::atomic<bool> _running{ false };
+    bool _stopping = false;
+    std::string _changesFile;
+    std::string _snapshotFile;
+    QueryCallbackProcessor _queryProcessor;
+};
+
+#define sChallengeModeLeaderboard ChallengeModeLeaderboard::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_LEADERBOARD_H
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesProvenance.h"
+#include "AuctionHouseMgr.h"
+#include "Mail.h"
+#include "ObjectAccessor.h"
+#include "Opcodes.h"
+#include "TradeData.h"
+#include "WorldPacket.h"
+#include <algorithm>
+#include <mutex>
+
+ChallengeModeProvenance* ChallengeModeProvenance::instance()
+{
+    static ChallengeModeProvenance instance;
+    return &instance;
+}
+
+bool ChallengeModeProvenance::IsEnrolled(Player* player)
+{
+    return sChallengeModes->challengeEnabledForPlayer(SETTING_SELF_CRAFTED, player) || sChallengeModes->challengeEnabledForPlayer(SETTING_IRON_MAN, player);
+}
+
+bool ChallengeModeProvenance::ObtainedByOwner(Player* player, Item* item) const
+{
+    if (!sChallengeModes->provenanceEnable)
+    {
+        return true;
+    }
+    ObjectGuid::LowType ownerGuid = player->GetGUID().GetCounter();
+    std::shared_lock<std::shared_mutex> guard(_lock);
+    if (!_loading.empty() && _loading.count(ownerGuid))
+    {
+        return false;
+    }
+    if (!_tradeOffers.empty())
+    {
+        auto offers = _tradeOffers.find(ownerGuid);
+        if (offers != _tradeOffers.end() && std::find(offers->second.begin(), offers->second.end(), item->GetGUID()) != offers->second.end())
+        {
+            return false;
+        }
+    }
+    // A tag only counts for the character it was written for, the item may have been handed on since
+    auto itr = _items.find(item->GetGUID().GetCounter());
+    return itr == _items.end() || itr->second.owner != ownerGuid;
+}
+
+void ChallengeModeProvenance::Tag(ObjectGuid::LowType itemGuid, ObjectGuid::LowType ownerGuid, ChallengeItemProvenance provenance, bool ownerOnline)
+{
+    if (ownerOnline)
+    {
+        CharacterDatabase.Execute("INSERT INTO challenge_mode_item_provenance (item_guid, owner_guid, provenance) VALUES ({}, {}, {}) "
+            "ON DUPLICATE KEY UPDATE owner_guid = VALUES(owner_guid), provenance = VALUES(provenance)", itemGuid, ownerGuid, uint8(provenance));
+
+        std::unique_lock<std::shared_mutex> guard(_lock);
+        _items[itemGuid] = { ownerGuid, provenance };
+        _ownerItems[ownerGuid].push_back(itemGuid);
+        return;
+    }
+
+    // Offline characters are only tagged when their stored settings have a provenance challenge enabled
+    CharacterDatabase.Execute(Acore::StringFormat("INSERT INTO challenge_mode_item_provenance (item_guid, owner_guid, provenance) "
+        "SELECT {}, {}, {} FROM character_settings s WHERE s.guid = {} AND s.source = 'mod-challenge-modes' AND ({} OR {}) "
+        "ON DUPLICATE KEY UPDATE owner_guid = VALUES(owner_guid), provenance = VALUES(provenance)",
+        itemGuid, ownerGuid, uint8(provenance), ownerGuid, ChallengeModes::settingEnabledSql(SETTING_SELF_CRAFTED), ChallengeModes::settingEnabledSql(SETTING_IRON_MAN)));
+}
+
+void ChallengeModeProvenance::LoadPlayer(ObjectGuid::LowType ownerGuid)
+{
+    {
+        std::unique_lock<std::shared_mutex> guard(_lock);
+        _loading.insert(ownerGuid);
+    }
+
+    _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery(Acore::StringFormat(
+        "SELECT item_guid, provenance FROM challenge_mode_item_provenance WHERE owner_guid = {}", ownerGuid)).WithCallback([this, ownerGuid](QueryResult result)
+    {
+        {
+            std::unique_lock<std::shared_mutex> guard(_lock);
+            // The player logged out before the query completed
+            if (!_loading.erase(ownerGuid) || !result)
+            {
+                return;
+            }
+            std::vector<ObjectGuid::LowType>& ownerItems = _ownerItems[ownerGuid];
+            do
+            {
+                Field* fields = result->Fetch();
+                ObjectGuid::LowType itemGuid = fields[0].Get<uint32>();
+                _items[itemGuid] = { ownerGuid, ChallengeItemProvenance(fields[1].Get<uint8>()) };
+                ownerItems.push_back(itemGuid);
+            } while (result->NextRow());
+        }
+
+        if (Player* player = ObjectAccessor::FindPlayerByLowGUID(ownerGuid))
+        {
+            UnequipTagged(player);
+        }
+    }));
+}
+
+void ChallengeModeProvenance::UnequipTagged(Player* player)
+{
+    for (uint8 slot = 0; slot < EQUIPMENT_SLOT_END; ++slot)
+    {
+        Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot);
+        if (!item || ObtainedByOwner(player, item))
+        {
+            continue;
+        }
+
+        ItemPosCountVec dest;
+        if (player->CanStoreItem(NULL_BAG, NULL_SLOT, dest, item, false) == EQUIP_ERR_OK)
+        {
+            player->RemoveItem(INVENTORY_SLOT_BAG_0, slot, true);
+            player->StoreItem(dest, item, true);
+            continue;
+        }
+
+        // No room in the bags, the item is mailed like the core does with gear it cannot equip while loading
+        player->MoveItemFromInventory(INVENTORY_SLOT_BAG_0, slot, true);
+        CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+        item->DeleteFromInventoryDB(trans);
+        item->SaveToDB(trans);
+        MailDraft("Challenge Mode", "Your challenge mode does not allow you to wear this item, it was unequipped and mailed to you.").AddItem(item).SendMailTo(trans, player, MailSender(player, MAIL_STATIONERY_GM), MAIL_CHECK_MASK_COPIED);
+        CharacterDatabase.CommitTransaction(trans);
+    }
+}
+
+void ChallengeModeProvenance::UnloadPlayer(ObjectGuid::LowType ownerGuid)
+{
+    std::unique_lock<std::shared_mutex> guard(_lock);
+    _loading.erase(ownerGuid);
+    auto itr = _ownerItems.find(ownerGuid);
+    if (itr == _ownerItems.end())
+    {
+        return;
+    }
+    for (ObjectGuid::LowType itemGuid : itr->second)
+    {
+        auto item = _items.find(itemGuid);
+        if (item != _items.end() && item->second.owner == ownerGuid)
+        {
+            _items.erase(item);
+        }
+    }
+    _ownerItems.erase(itr);
+}
+
+void ChallengeModeProvenance::OfferTrade(ObjectGuid itemGuid, ObjectGuid::LowType receiverGuid)
+{
+    std::unique_lock<std::shared_mutex> guard(_lock);
+    std::vector<ObjectGuid>& offers = _tradeOffers[receiverGuid];
+    if (std::find(offers.begin(), offers.end(), itemGuid) == offers.end())
+    {
+        offers.push_back(itemGuid);
+    }
+}
+
+void ChallengeModeProvenance::CommitTrade(Player* receiver)
+{
+    ObjectGuid::LowType receiverGuid = receiver->GetGUID().GetCounter();
+    std::vector<ObjectGuid> received;
+    {
+        std::unique_lock<std::shared_mutex> guard(_lock);
+        auto itr = _tradeOffers.find(receiverGuid);
+        if (itr == _tradeOffers.end())
+        {
+            return;
+        }
+        std::vector<ObjectGuid>& offers = itr->second;
+        for (auto offer = offers.begin(); offer != offers.end();)
+        {
+            if (receiver->GetItemByGuid(*offer))
+            {
+                received.push_back(*offer);
+                offer = offers.erase(offer);
+            }
+            else
+            {
+                ++offer;
+            }
+        }
+        // Offers of a trade that closed without handing them over were cancelled
+        if (offers.empty() || !receiver->GetTradeData())
+        {
+            _tradeOffers.erase(itr);
+        }
+    }
+
+    for (ObjectGuid const& itemGuid : received)
+    {
+        Tag(itemGuid.GetCounter(), receiverGuid, ITEM_PROVENANCE_TRADED, true);
+    }
+}
+
+void ChallengeModeProvenance::DeleteOrphans()
+{
+    CharacterDatabase.Execute("DELETE p FROM challenge_mode_item_provenance p LEFT JOIN item_instance i ON i.guid = p.item_guid WHERE i.guid IS NULL");
+}
+
+void ChallengeModeProvenance::Update()
+{
+    _queryProcessor.ProcessReadyCallbacks();
+
+    if (_tradeOffers.empty())
+    {
+        return;
+    }
+    std::vector<ObjectGuid::LowType> receivers;
+    {
+        std::shared_lock<std::shared_mutex> guard(_lock);
+        for (auto const& [receiverGuid, offers] : _tradeOffers)
+        {
+            receivers.push_back(receiverGuid);
+        }
+    }
+    for (ObjectGuid::LowType receiverGuid : receivers)
+    {
+        if (Player* receiver = ObjectAccessor::FindPlayerByLowGUID(receiverGuid))
+        {
+            CommitTrade(receiver);
+        }
+        else
+        {
+            std::unique_lock<std::shared_mutex> guard(_lock);
+            _tradeOffers.erase(receiverGuid);
+        }
+    }
+}
+
+class ChallengeModes_ProvenanceScript : public PlayerScript
+{
+public:
+    ChallengeModes_ProvenanceScript() : PlayerScript("ChallengeModes_ProvenanceScript") { }
+
+    void OnPlayerLogin(Player* player) override
+    {
+        if (sChallengeModes->enabled() && sChallengeModes->provenanceEnable && ChallengeModeProvenance::IsEnrolled(player))
+        {
+            sChallengeModeProvenance->LoadPlayer(player->GetGUID().GetCounter());
+        }
+    }
+
+    void OnPlayerLogout(Player* player) override
+    {
+        // A trade completed in the same world update as the logout is tagged before the receiver leaves
+        sChallengeModeProvenance->CommitTrade(player);
+        sChallengeModeProvenance->UnloadPlayer(player->GetGUID().GetCounter());
+    }
+
+    bool OnPlayerCanInitTrade(Player* player, Player* target) override
+    {
+        if (!sChallengeModes->enabled() || !sChallengeModes->provenanceEnable || !sChallengeModes->provenanceBlockTrade)
+        {
+            return true;
+        }
+        if (ChallengeModeProvenance::IsEnrolled(player) || ChallengeModeProvenance::IsEnrolled(target))
+        {
+            ChatHandler(player->GetSession()).SendSysMessage("挑战模式角色无法进行交易。");
+            return false;
+        }
+        return true;
+    }
+
+    bool OnPlayerCanSetTradeItem(Player* player, Item* tradedItem, uint8 /*tradeSlot*/) override
+    {
+        if (!sChallengeModes->enabled() || !sChallengeModes->provenanceEnable)
+        {
+            return true;
+        }
+        // Trading is allowed by the config, the offered item is tagged by the world update once the trade completed
+        TradeData* tradeData = player->GetTradeData();
+        Player* trader = tradeData ? tradeData->GetTrader() : nullptr;
+        if (trader && ChallengeModeProvenance::IsEnrolled(trader))
+        {
+            sChallengeModeProvenance->OfferTrade(tradedItem->GetGUID(), trader->GetGUID().GetCounter());
+        }
+        return true;
+    }
+
+    bool OnPlayerCanSendMail(Player* player, ObjectGuid receiverGuid, ObjectGuid /*mailbox*/, std::string& /*subject*/, std::string& /*body*/, uint32 /*money*/, uint32 /*COD*/, Item* item) override
+    {
+        if (!sChallengeModes->enabled() || !sChallengeModes->provenanceEnable || !sChallengeModes->provenanceBlockMail)
+        {
+            return true;
+        }
+        if (ChallengeModeProvenance::IsEnrolled(player))
+        {
+            ChatHandler(player->GetSession()).SendSysMessage("挑战模式角色无法发送邮件。");
+            return false;
+        }
+        Player* receiver = ObjectAccessor::FindConnectedPlayer(receiverGuid);
+        if (item && receiver && ChallengeModeProvenance::IsEnrolled(receiver))
+        {
+            ChatHandler(player->GetSession()).SendSysMessage("无法向挑战模式角色邮寄物品。");
+            return false;
+        }
+        return true;
+    }
+
+    bool OnPlayerCanPlaceAuctionBid(Player* player, AuctionEntry* /*auction*/) override
+    {
+        if (!sChallengeModes->enabled() || !sChallengeModes->provenanceEnable || !sChallengeModes->provenanceBlockAuction)
+        {
+            return true;
+        }
+        if (ChallengeModeProvenance::IsEnrolled(player))
+        {
+            ChatHandler(player->GetSession()).SendSysMessage("挑战模式角色无法在拍卖行竞拍。");
+            return false;
+        }
+        return true;
+    }
+};
+
+// The core has no hook to refuse a new auction, so the sell request of enrolled characters is dropped before it is handled
+class ChallengeModes_ProvenanceServerScript : public ServerScript
+{
+public:
+    ChallengeModes_ProvenanceServerScript() : ServerScript("ChallengeModes_ProvenanceServerScript") { }
+
+    bool CanPacketReceive(WorldSession* session, WorldPacket const& packet) override
+    {
+        if (packet.GetOpcode() != CMSG_AUCTION_SELL_ITEM || !sChallengeModes->enabled() || !sChallengeModes->provenanceEnable || !sChallengeModes->provenanceBlockAuction)
+        {
+            return true;
+        }
+        Player* player = session->GetPlayer();
+        if (player && ChallengeModeProvenance::IsEnrolled(player))
+        {
+            ChatHandler(session).SendSysMessage("挑战模式角色无法在拍卖行出售物品。");
+            return false;
+        }
+        return true;
+    }
+};
+
+class ChallengeModes_ProvenanceMailScript : public MailScript
+{
+public:
+    ChallengeModes_ProvenanceMailScript() : MailScript("ChallengeModes_ProvenanceMailScript") { }
+
+    void OnBeforeMailDraftSendMailTo(MailDraft* mailDraft, MailReceiver const& receiver, MailSender const& sender, MailCheckMask& checked, uint32& /*deliver_delay*/,
+        uint32& /*custom_expiration*/, bool& /*deleteMailItemsFromDB*/, bool& /*sendMail*/) override
+    {
+        if (!sChallengeModes->enabled() || !sChallengeModes->provenanceEnable || (checked & MAIL_CHECK_MASK_RETURNED) || mailDraft->GetItems().empty())
+        {
+            return;
+        }
+
+        ChallengeItemProvenance provenance;
+        switch (sender.GetMailMessageType())
+        {
+            case MAIL_NORMAL:
+                provenance = ITEM_PROVENANCE_MAILED;
+                break;
+            case MAIL_AUCTION:
+            {
+                // Auction mail subjects are "item:random property:response:...", only won auctions carry a bought item
+                std::string const& subject = mailDraft->GetSubject();
+                size_t responsePos = subject.find(':', subject.find(':') + 1);
+                if (responsePos == std::string::npos || atoi(subject.c_str() + responsePos + 1) != AUCTION_WON)
+                {
+                    return;
+                }
+                provenance = ITEM_PROVENANCE_AUCTION;
+                break;
+            }
+            default:
+                // Items from NPCs and the module's own rewards count as obtained by the player
+                return;
+        }
+
+        Player* player = receiver.GetPlayer();
+        if (player && !ChallengeModeProvenance::IsEnrolled(player))
+        {
+            return;
+        }
+        for (auto const& [itemGuid, item] : mailDraft->GetItems())
+        {
+            sChallengeModeProvenance->Tag(itemGuid, receiver.GetPlayerGUIDLow(), provenance, player != nullptr);
+        }
+    }
+};
+
+void AddSC_mod_challenge_modes_provenance()
+{
+    new ChallengeModes_ProvenanceScript();
+    new ChallengeModes_ProvenanceServerScript();
+    new ChallengeModes_ProvenanceMailScript();
+}
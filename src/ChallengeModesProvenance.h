@@ -0,0 +1,69 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_PROVENANCE_H
+#define AZEROTHCORE_CHALLENGEMODES_PROVENANCE_H
+
+#include "ChallengeModes.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Items looted or crafted by their owner have no provenance row, only items that reached a challenge player from someone else are tracked
+enum ChallengeItemProvenance : uint8
+{
+    ITEM_PROVENANCE_OWNED   = 0,
+    ITEM_PROVENANCE_TRADED  = 1,
+    ITEM_PROVENANCE_MAILED  = 2,
+    ITEM_PROVENANCE_AUCTION = 3
+};
+
+// Modes that only allow gear obtained by the player themselves
+constexpr uint32 provenanceChallengeMask = challengeModeMask(SETTING_SELF_CRAFTED) | challengeModeMask(SETTING_IRON_MAN);
+
+struct ChallengeItemTag
+{
+    ObjectGuid::LowType owner;
+    ChallengeItemProvenance provenance;
+};
+
+// Provenance of item instances is stored in challenge_mode_item_provenance keyed by item guid.
+// Only the items of online challenge players are kept in memory so an equip check is a single hash lookup.
+class ChallengeModeProvenance
+{
+public:
+    static ChallengeModeProvenance* instance();
+
+    [[nodiscard]] static bool IsEnrolled(Player* player);
+
+    // Thread safe, may be called from map update threads
+    // Whether the item was obtained by the player themselves, items are refused while the player's provenance is still loading
+    // and while they are offered to the player in an open trade
+    [[nodiscard]] bool ObtainedByOwner(Player* player, Item* item) const;
+    void Tag(ObjectGuid::LowType itemGuid, ObjectGuid::LowType ownerGuid, ChallengeItemProvenance provenance, bool ownerOnline);
+
+    // World thread only
+    void LoadPlayer(ObjectGuid::LowType ownerGuid);
+    void UnloadPlayer(ObjectGuid::LowType ownerGuid);
+    // Offered items are only tagged once the trade completed and they are in the receiver's inventory
+    void OfferTrade(ObjectGuid itemGuid, ObjectGuid::LowType receiverGuid);
+    void CommitTrade(Player* receiver);
+    void DeleteOrphans();
+    void Update();
+
+private:
+    // Unequips worn items the player did not obtain themselves, their provenance is only known after the equip checks of the login
+    void UnequipTagged(Player* player);
+
+    mutable std::shared_mutex _lock;
+    std::unordered_map<ObjectGuid::LowType, ChallengeItemTag> _items;
+    std::unordered_map<ObjectGuid::LowType, std::vector<ObjectGuid::LowType>> _ownerItems;
+    std::unordered_set<ObjectGuid::LowType> _loading;
+    // Items offered in open trades, by receiver
+    std::unordered_map<ObjectGuid::LowType, std::vector<ObjectGuid>> _tradeOffers;
+    QueryCallbackProcessor _queryProcessor;
+};
+
+#define sChallengeModeProvenance ChallengeModeProvenance::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_PROVENANCE_H
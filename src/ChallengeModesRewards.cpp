@@ -0,0 +1,597 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesRewards.h"
+#include "ChallengeModesStats.h"
+#include "Mail.h"
+#include "ObjectAccessor.h"
+#include <algorithm>
+#include <sstream>
+
+ChallengeModeRewards* ChallengeModeRewards::instance()
+{
+    static ChallengeModeRewards instance;
+    return &instance;
+}
+
+void ChallengeModeRewards::QueueLevelRewards(Player* player, ChallengeModeSettings setting, uint8 level)
+{
+    // Most level ups have no reward and return here without touching the reward maps
+    if (!sChallengeModes->hasRewardAtLevel(setting, level))
+    {
+        return;
+    }
+
+    ObjectGuid::LowType guid = player->GetGUID().GetCounter();
+
+    const std::unordered_map<uint8, uint32>* titleRewardMap = sChallengeModes->getTitleMapForChallenge(setting);
+    const std::unordered_map<uint8, uint32>* talentRewardMap = sChallengeModes->getTalentMapForChallenge(setting);
+    const std::unordered_map<uint8, uint32>* itemRewardMap = sChallengeModes->getItemMapForChallenge(setting);
+    const std::unordered_map<uint8, uint32>* achievementRewardMap = sChallengeModes->getAchievementMapForChallenge(setting);
+
+    auto titleItr = titleRewardMap->find(level);
+    if (titleItr != titleRewardMap->end())
+    {
+        QueueReward({ guid, uint8(setting), level, REWARD_TYPE_TITLE, titleItr->second, 1 });
+    }
+
+    auto talentItr = talentRewardMap->find(level);
+    if (talentItr != talentRewardMap->end())
+    {
+        QueueReward({ guid, uint8(setting), level, REWARD_TYPE_TALENT, 0, talentItr->second });
+    }
+
+    auto achievementItr = achievementRewardMap->find(level);
+    if (achievementItr != achievementRewardMap->end())
+    {
+        QueueReward({ guid, uint8(setting), level, REWARD_TYPE_ACHIEVEMENT, achievementItr->second, 1 });
+    }
+
+    auto itemItr = itemRewardMap->find(level);
+    if (itemItr != itemRewardMap->end())
+    {
+        QueueReward({ guid, uint8(setting), level, REWARD_TYPE_ITEM, itemItr->second, sChallengeModes->getItemRewardAmount(setting) });
+    }
+}
+
+void ChallengeModeRewards::QueueReward(ChallengeModeReward const& reward)
+{
+    std::lock_guard<std::mutex> guard(_queueLock);
+    _queuedRewards.push_back(reward);
+    _pendingGuids.insert(reward.guid);
+}
+
+void ChallengeModeRewards::RequestDelivery(ObjectGuid::LowType guid)
+{
+    std::lock_guard<std::mutex> guard(_queueLock);
+    _pendingGuids.insert(guid);
+}
+
+void ChallengeModeRewards::Update(uint32 diff)
+{
+    _transactionProcessor.ProcessReadyCallbacks();
+    _queryProcessor.ProcessReadyCallbacks();
+    UpdateBackfill(diff);
+
+    if (_deliveryInFlight)
+    {
+        return;
+    }
+    if (_deliveryTimer > diff)
+    {
+        _deliveryTimer -= diff;
+        return;
+    }
+    _deliveryTimer = sChallengeModes->rewardDeliveryInterval;
+    StartDelivery();
+}
+
+void ChallengeModeRewards::StartDelivery()
+{
+    std::vector<ChallengeModeReward> rewards;
+    std::vector<ObjectGuid::LowType> guids;
+    {
+        std::lock_guard<std::mutex> guard(_queueLock);
+        rewards.swap(_queuedRewards);
+        for (auto itr = _pendingGuids.begin(); itr != _pendingGuids.end() && guids.size() < sChallengeModes->rewardDeliveryBatchSize;)
+        {
+            guids.push_back(*itr);
+            itr = _pendingGuids.erase(itr);
+        }
+    }
+
+    if (rewards.empty() && guids.empty())
+    {
+        return;
+    }
+    _deliveryInFlight = true;
+
+    if (rewards.empty())
+    {
+        LoadPendingRewards(guids);
+        return;
+    }
+
+    // INSERT IGNORE keeps rows that already exist, so a level that is reached again never grants twice
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    for (ChallengeModeReward const& reward : rewards)
+    {
+        trans->Append("INSERT IGNORE INTO challenge_mode_rewards (guid, mode, level, reward_type, reward_id, amount) VALUES ({}, {}, {}, {}, {}, {})",
+            reward.guid, reward.mode, reward.level, reward.type, reward.rewardId, reward.amount);
+    }
+    _transactionProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([this, rewards, guids](bool success)
+    {
+        if (!success)
+        {
+            LOG_ERROR("mod-challenge-modes", "Failed to record {} challenge rewards, retrying.", rewards.size());
+            std::lock_guard<std::mutex> guard(_queueLock);
+            _queuedRewards.insert(_queuedRewards.end(), rewards.begin(), rewards.end());
+            _pendingGuids.insert(guids.begin(), guids.end());
+            _deliveryInFlight = false;
+            return;
+        }
+        LoadPendingRewards(guids);
+    });
+}
+
+void ChallengeModeRewards::LoadPendingRewards(std::vector<ObjectGuid::LowType> const& guids)
+{
+    if (guids.empty())
+    {
+        _deliveryInFlight = false;
+        return;
+    }
+
+    std::string guidList;
+    for (ObjectGuid::LowType guid : guids)
+    {
+        if (!guidList.empty())
+        {
+            guidList += ',';
+        }
+        guidList += std::to_string(guid);
+    }
+
+    _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery(Acore::StringFormat(
+        "SELECT guid, mode, level, reward_type, reward_id, amount FROM challenge_mode_rewards WHERE state = {} AND guid IN ({})",
+        uint8(REWARD_STATE_PENDING), guidList)).WithCallback([this](QueryResult result)
+    {
+        DeliverRewards(result);
+    }));
+}
+
+void ChallengeModeRewards::DeliverRewards(QueryResult result)
+{
+    if (!result)
+    {
+        _deliveryInFlight = false;
+        return;
+    }
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    std::vector<ChallengeModeReward> delivered;
+    std::unordered_set<Player*> rewardedPlayers;
+    do
+    {
+        Field* fields = result->Fetch();
+        ChallengeModeReward reward{ fields[0].Get<uint32>(), fields[1].Get<uint8>(), fields[2].Get<uint8>(), fields[3].Get<uint8>(), fields[4].Get<uint32>(), fields[5].Get<uint32>() };
+
+        // Items are sent by mail and can be delivered to offline characters, everything else waits for the next login
+        Player* player = ObjectAccessor::FindPlayerByLowGUID(reward.guid);
+        if (!player && reward.type != REWARD_TYPE_ITEM)
+        {
+            continue;
+        }
+
+        // A grant whose commit failed is still applied in memory and is only recorded again
+        if (!IsUnrecordedGrant(reward) && !DeliverReward(player, reward, trans))
+        {
+            SetRewardState(trans, reward, REWARD_STATE_INVALID);
+            continue;
+        }
+        SetRewardState(trans, reward, REWARD_STATE_DELIVERED);
+        delivered.push_back(reward);
+        if (player && reward.type != REWARD_TYPE_ITEM)
+        {
+            rewardedPlayers.insert(player);
+        }
+    } while (result->NextRow());
+
+    // The character is saved in the same transaction that marks its rewards delivered, so the ledger and the character never disagree
+    for (Player* player : rewardedPlayers)
+    {
+        player->SaveToDB(trans, false, false);
+    }
+
+    _transactionProcessor.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([this, delivered](bool success)
+    {
+        _deliveryInFlight = false;
+        for (ChallengeModeReward const& reward : delivered)
+        {
+            if (success)
+            {
+                ForgetUnrecordedGrant(reward);
+                sChallengeModeStats->RecordReward(reward.mode, reward.type);
+            }
+            else if (reward.type != REWARD_TYPE_ITEM)
+            {
+                // The rows stay pending, the character keeps the grant in memory until the next delivery or its logout records it
+                _unrecordedGrants[reward.guid].push_back(reward);
+            }
+        }
+        if (!success)
+        {
+            LOG_ERROR("mod-challenge-modes", "Failed to commit challenge reward delivery.");
+        }
+    });
+}
+
+bool ChallengeModeRewards::IsUnrecordedGrant(ChallengeModeReward const& reward) const
+{
+    auto itr = _unrecordedGrants.find(reward.guid);
+    if (itr == _unrecordedGrants.end())
+    {
+        return false;
+    }
+    return std::any_of(itr->second.begin(), itr->second.end(), [&reward](ChallengeModeReward const& grant)
+    {
+        return grant.mode == reward.mode && grant.level == reward.level && grant.type == reward.type;
+    });
+}
+
+void ChallengeModeRewards::ForgetUnrecordedGrant(ChallengeModeReward const& reward)
+{
+    auto itr = _unrecordedGrants.find(reward.guid);
+    if (itr == _unrecordedGrants.end())
+    {
+        return;
+    }
+    std::vector<ChallengeModeReward>& grants = itr->second;
+    grants.erase(std::remove_if(grants.begin(), grants.end(), [&reward](ChallengeModeReward const& grant)
+    {
+        return grant.mode == reward.mode && grant.level == reward.level && grant.type == reward.type;
+    }), grants.end());
+    if (grants.empty())
+    {
+        _unrecordedGrants.erase(itr);
+    }
+}
+
+void ChallengeModeRewards::RecordGrants(Player* player)
+{
+    auto itr = _unrecordedGrants.find(player->GetGUID().GetCounter());
+    if (itr == _unrecordedGrants.end())
+    {
+        return;
+    }
+
+    // The logout save writes the grants, so the ledger rows are committed with a save of their own before the character leaves
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    for (ChallengeModeReward const& reward : itr->second)
+    {
+        SetRewardState(trans, reward, REWARD_STATE_DELIVERED);
+    }
+    player->SaveToDB(trans, false, false);
+    CharacterDatabase.CommitTransaction(trans);
+    _unrecordedGrants.erase(itr);
+}
+
+void ChallengeModeRewards::SetRewardState(CharacterDatabaseTransaction trans, ChallengeModeReward const& reward, ChallengeModeRewardState state)
+{
+    trans->Append("UPDATE challenge_mode_rewards SET state = {}, delivered = {} WHERE guid = {} AND mode = {} AND level = {} AND reward_type = {}",
+        uint8(state), state == REWARD_STATE_PENDING ? "NULL" : "NOW()", reward.guid, reward.mode, reward.level, reward.type);
+}
+
+// The message is only built when a title is actually delivered, from the title names of the player's locale in Titles.dbc
+void ChallengeModeRewards::AnnounceTitle(Player* player, CharTitlesEntry const* titleInfo)
+{
+    ChatHandler handler(player->GetSession());
+    LocaleConstant locale = handler.GetSessionDbcLocale();
+    char const* const* titleNames = player->getGender() == GENDER_MALE ? titleInfo->nameMale : titleInfo->nameFemale;
+    char const* titleName = titleNames[locale] && *titleNames[locale] ? titleNames[locale] : titleNames[LOCALE_enUS];
+    if (!titleName || !*titleName)
+    {
+        return;
+    }
+
+    std::string title(titleName);
+    size_t namePos = title.find("%s");
+    if (namePos != std::string::npos)
+    {
+        title.replace(namePos, 2, player->GetName());
+    }
+    handler.SendSysMessage(Acore::StringFormat("|cffDA70D6你获得了称号: |cffffffff{}|r", title));
+}
+
+bool ChallengeModeRewards::DeliverReward(Player* player, ChallengeModeReward const& reward, CharacterDatabaseTransaction trans)
+{
+    switch (reward.type)
+    {
+        case REWARD_TYPE_TITLE:
+        {
+            CharTitlesEntry const* titleInfo = sCharTitlesStore.LookupEntry(reward.rewardId);
+            if (!titleInfo)
+            {
+                LOG_ERROR("mod-challenge-modes", "Invalid title ID {}!", reward.rewardId);
+                return false;
+            }
+            // A grant that was saved with the character but not recorded in the ledger is not announced again
+            if (player->HasTitle(titleInfo))
+            {
+                return true;
+            }
+            player->SetTitle(titleInfo);
+            if (sChallengeModes->rewardAnnounce)
+            {
+                AnnounceTitle(player, titleInfo);
+            }
+            return true;
+        }
+        case REWARD_TYPE_TALENT:
+            player->RewardExtraBonusTalentPoints(reward.amount);
+            return true;
+        case REWARD_TYPE_ACHIEVEMENT:
+        {
+            AchievementEntry const* achievementInfo = sAchievementStore.LookupEntry(reward.rewardId);
+            if (!achievementInfo)
+            {
+                LOG_ERROR("mod-challenge-modes", "Invalid Achievement ID {}!", reward.rewardId);
+                return false;
+            }
+            if (!player->HasAchieved(reward.rewardId))
+            {
+                player->CompletedAchievement(achievementInfo);
+            }
+            return true;
+        }
+        case REWARD_TYPE_ITEM:
+        {
+            Item* item = Item::CreateItem(reward.rewardId, reward.amount);
+            if (!item)
+            {
+                LOG_ERROR("mod-challenge-modes", "Invalid item ID {}!", reward.rewardId);
+                return false;
+            }
+            MailSender sender(MAIL_CREATURE, 34337 /* The Postmaster */);
+            MailDraft draft("Recovered Item", "We recovered a lost item in the twisting nether and noted that it was yours.$B$BPlease find said object enclosed.");
+            item->SaveToDB(trans);
+            draft.AddItem(item);
+            draft.SendMailTo(trans, player ? MailReceiver(player, reward.guid) : MailReceiver(reward.guid), sender);
+            return true;
+        }
+        default:
+            break;
+    }
+    return false;
+}
+
+bool ChallengeModeRewards::StartBackfill(ChallengeModeSettings setting, int8 rewardType, ObjectGuid issuer)
+{
+    if (_backfill.running)
+    {
+        return false;
+    }
+    _backfill = ChallengeModeBackfill();
+    _backfill.running = true;
+    _backfill.mode = setting;
+    _backfill.rewardType = rewardType;
+    _backfill.issuer = issuer;
+    return true;
+}
+
+void ChallengeModeRewards::StopBackfill()
+{
+    // A page that is already loading is dropped when it arrives
+    _backfill.running = false;
+}
+
+void ChallengeModeRewards::UpdateBackfill(uint32 diff)
+{
+    if (!_backfill.running || _backfill.pageInFlight)
+    {
+        return;
+    }
+    if (_backfill.timer > diff)
+    {
+        _backfill.timer -= diff;
+        return;
+    }
+    _backfill.timer = sChallengeModes->backfillInterval;
+    LoadBackfillPage();
+}
+
+bool ChallengeModeRewards::BackfillsRewardType(ChallengeModeRewardType rewardType) const
+{
+    // Titles and achievements are granted at most once by the core, talent points and items add up so they are only backfilled on request
+    if (_backfill.rewardType < 0)
+    {
+        return rewardType == REWARD_TYPE_TITLE || rewardType == REWARD_TYPE_ACHIEVEMENT;
+    }
+    return _backfill.rewardType == rewardType;
+}
+
+void ChallengeModeRewards::LoadBackfillPage()
+{
+    _backfill.pageInFlight = true;
+    ChallengeModeSettings setting = _backfill.mode;
+
+    // Talent points and items granted before the reward ledger existed are only visible on the character
+    std::string talentColumn = "CAST(0 AS SIGNED)";
+    if (BackfillsRewardType(REWARD_TYPE_TALENT))
+    {
+        talentColumn = Acore::StringFormat("CAST(c.extra_bonus_talent_count AS SIGNED) - CAST((SELECT COALESCE(SUM(r.amount), 0) FROM challenge_mode_rewards r "
+            "WHERE r.guid = c.guid AND r.reward_type = {} AND r.state = {}) AS SIGNED)", uint8(REWARD_TYPE_TALENT), uint8(REWARD_STATE_DELIVERED));
+    }
+    std::string itemColumn = "NULL";
+    if (BackfillsRewardType(REWARD_TYPE_ITEM) && !sChallengeModes->getItemMapForChallenge(setting)->empty())
+    {
+        std::string itemList;
+        for (auto const& [rewardLevel, itemId] : *sChallengeModes->getItemMapForChallenge(setting))
+        {
+            if (!itemList.empty())
+            {
+                itemList += ',';
+            }
+            itemList += std::to_string(itemId);
+        }
+        itemColumn = Acore::StringFormat("(SELECT GROUP_CONCAT(DISTINCT i.itemEntry) FROM item_instance i WHERE i.owner_guid = c.guid AND i.itemEntry IN ({}))", itemList);
+    }
+
+    // Keyset pagination on the character guid keeps every page an index range scan
+    _queryProcessor.AddCallback(CharacterDatabase.AsyncQuery(Acore::StringFormat(
+        "SELECT c.guid, c.level, c.class, s.data, CAST(EXISTS (SELECT 1 FROM challenge_mode_rewards r WHERE r.guid = c.guid AND r.mode = {}) AS SIGNED), {}, {} "
+        "FROM characters c JOIN character_settings s ON s.guid = c.guid AND s.source = 'mod-challenge-modes' "
+        "WHERE c.guid > {} ORDER BY c.guid LIMIT {}", uint8(setting), talentColumn, itemColumn, _backfill.lastGuid, sChallengeModes->backfillPageSize)).WithCallback([this](QueryResult result)
+    {
+        _backfill.pageInFlight = false;
+        QueueBackfillPage(result);
+    }));
+}
+
+void ChallengeModeRewards::QueueBackfillPage(QueryResult result)
+{
+    if (!_backfill.running)
+    {
+        return;
+    }
+
+    ChallengeModeSettings setting = _backfill.mode;
+    uint32 disableLevel = sChallengeModes->getDisableLevel(setting);
+    const std::unordered_map<uint8, uint32>* rewardMaps[] =
+    {
+        sChallengeModes->getTitleMapForChallenge(setting),
+        sChallengeModes->getTalentMapForChallenge(setting),
+        sChallengeModes->getItemMapForChallenge(setting),
+        sChallengeModes->getAchievementMapForChallenge(setting)
+    };
+    ChallengeModeRewardType rewardTypes[] = { REWARD_TYPE_TITLE, REWARD_TYPE_TALENT, REWARD_TYPE_ITEM, REWARD_TYPE_ACHIEVEMENT };
+
+    std::vector<ChallengeModeReward> rewards;
+    std::vector<ObjectGuid::LowType> onlineGuids;
+    uint64 rows = result ? result->GetRowCount() : 0;
+    if (result)
+    {
+        do
+        {
+            Field* fields = result->Fetch();
+            ObjectGuid::LowType guid = fields[0].Get<uint32>();
+            uint8 level = fields[1].Get<uint8>();
+            _backfill.lastGuid = guid;
+
+            // DisableLevel turns the challenge off, characters it ended for are recognised by their ledger rows and rewarded up to that level
+            uint8 maxLevel = level;
+            if (!ChallengeModes::settingEnabledInData(fields[3].Get<std::string>(), setting))
+            {
+                if (!disableLevel || level < disableLevel || !fields[4].Get<int64>())
+                {
+                    continue;
+                }
+                maxLevel = uint8(std::min<uint32>(disableLevel, level));
+            }
+            ++_backfill.characters;
+
+            // Rewards are earned by level ups after enrolling, Death Knights enroll at their starting level
+            uint8 enrollLevel = ChallengeModes::getEnrollLevel(fields[2].Get<uint8>());
+            bool hasUnrecordedTalents = fields[5].Get<int64>() > 0;
+            std::unordered_set<uint32> ownedItems;
+            if (!fields[6].IsNull())
+            {
+                std::stringstream itemStream(fields[6].Get<std::string>());
+                std::string itemId;
+                while (std::getline(itemStream, itemId, ','))
+                {
+                    ownedItems.insert(atoi(itemId.c_str()));
+                }
+            }
+
+            size_t queuedBefore = rewards.size();
+            for (uint8 i = 0; i < 4; ++i)
+            {
+                if (!BackfillsRewardType(rewardTypes[i]) || (rewardTypes[i] == REWARD_TYPE_TALENT && hasUnrecordedTalents))
+                {
+                    continue;
+                }
+                for (auto const& [rewardLevel, value] : *rewardMaps[i])
+                {
+                    if (rewardLevel <= enrollLevel || rewardLevel > maxLevel)
+                    {
+                        continue;
+                    }
+                    switch (rewardTypes[i])
+                    {
+                        case REWARD_TYPE_TALENT:
+                            rewards.push_back({ guid, uint8(setting), rewardLevel, REWARD_TYPE_TALENT, 0, value });
+                            break;
+                        case REWARD_TYPE_ITEM:
+                            if (!ownedItems.count(value))
+                            {
+                                rewards.push_back({ guid, uint8(setting), rewardLevel, REWARD_TYPE_ITEM, value, sChallengeModes->getItemRewardAmount(setting) });
+                            }
+                            break;
+                        default:
+                            rewards.push_back({ guid, uint8(setting), rewardLevel, uint8(rewardTypes[i]), value, 1 });
+                            break;
+                    }
+                }
+            }
+            // Offline characters pick their rewards up at login, only online ones are delivered right away
+            if (rewards.size() != queuedBefore && ObjectAccessor::FindPlayerByLowGUID(guid))
+            {
+                onlineGuids.push_back(guid);
+            }
+        } while (result->NextRow());
+    }
+
+    _backfill.rewards += rewards.size();
+    {
+        std::lock_guard<std::mutex> guard(_queueLock);
+        _queuedRewards.insert(_queuedRewards.end(), rewards.begin(), rewards.end());
+        _pendingGuids.insert(onlineGuids.begin(), onlineGuids.end());
+    }
+
+    if (rows < sChallengeModes->backfillPageSize)
+    {
+        _backfill.running = false;
+        ReportBackfill(Acore::StringFormat("{} 奖励回填完成: 已检查 {} 个角色, 已排队 {} 项奖励。",
+            ChallengeModes::getChallengeName(setting), _backfill.characters, _backfill.rewards));
+        return;
+    }
+    ReportBackfill(Acore::StringFormat("{} 奖励回填进度: 角色 GUID {}, 已检查 {} 个角色, 已排队 {} 项奖励。",
+        ChallengeModes::getChallengeName(setting), _backfill.lastGuid, _backfill.characters, _backfill.rewards));
+}
+
+void ChallengeModeRewards::ReportBackfill(std::string const& message) const
+{
+    LOG_INFO("mod-challenge-modes", "{}", message);
+    if (Player* issuer = ObjectAccessor::FindConnectedPlayer(_backfill.issuer))
+    {
+        ChatHandler(issuer->GetSession()).SendSysMessage(message);
+    }
+}
+
+class ChallengeModes_RewardScript : public PlayerScript
+{
+public:
+    ChallengeModes_RewardScript() : PlayerScript("ChallengeModes_RewardScript") { }
+
+    void OnPlayerLogin(Player* player) override
+    {
+        if (!sChallengeModes->enabled())
+        {
+            return;
+        }
+        // Pick up rewards that were queued while the character was offline
+        sChallengeModeRewards->RequestDelivery(player->GetGUID().GetCounter());
+    }
+
+    void OnPlayerLogout(Player* player) override
+    {
+        sChallengeModeRewards->RecordGrants(player);
+    }
+};
+
+void AddSC_mod_challenge_modes_rewards()
+{
+    new ChallengeModes_RewardScript();
+}
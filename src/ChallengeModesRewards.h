@@ -0,0 +1,102 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_REWARDS_H
+#define AZEROTHCORE_CHALLENGEMODES_REWARDS_H
+
+#include "ChallengeModes.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+enum ChallengeModeRewardType
+{
+    REWARD_TYPE_TITLE       = 0,
+    REWARD_TYPE_TALENT      = 1,
+    REWARD_TYPE_ITEM        = 2,
+    REWARD_TYPE_ACHIEVEMENT = 3
+};
+
+enum ChallengeModeRewardState
+{
+    REWARD_STATE_PENDING   = 0,
+    REWARD_STATE_DELIVERED = 1,
+    REWARD_STATE_INVALID   = 2
+};
+
+struct ChallengeModeReward
+{
+    ObjectGuid::LowType guid;
+    uint8 mode;
+    uint8 level;
+    uint8 type;
+    uint32 rewardId;
+    uint32 amount;
+};
+
+struct ChallengeModeBackfill
+{
+    bool running = false;
+    bool pageInFlight = false;
+    ChallengeModeSettings mode = SETTING_HARDCORE;
+    int8 rewardType = -1; // -1 backfills titles and achievements
+    ObjectGuid issuer;
+    ObjectGuid::LowType lastGuid = 0;
+    uint32 characters = 0;
+    uint32 rewards = 0;
+    uint32 timer = 0;
+};
+
+// Rewards are recorded in the challenge_mode_rewards ledger keyed by (guid, mode, level, reward type).
+// Player hooks only queue ledger rows, the world thread persists them and delivers pending rows in batches.
+class ChallengeModeRewards
+{
+public:
+    static ChallengeModeRewards* instance();
+
+    // Thread safe, may be called from map update threads
+    void QueueLevelRewards(Player* player, ChallengeModeSettings setting, uint8 level);
+    void QueueReward(ChallengeModeReward const& reward);
+    void RequestDelivery(ObjectGuid::LowType guid);
+
+    // World thread only
+    void Update(uint32 diff);
+    // Records grants whose delivery commit failed while the character still has them, before its logout save writes them
+    void RecordGrants(Player* player);
+
+    // Streams characters with the challenge enabled from the characters database and queues rewards for levels they already passed
+    bool StartBackfill(ChallengeModeSettings setting, int8 rewardType, ObjectGuid issuer);
+    void StopBackfill();
+    [[nodiscard]] ChallengeModeBackfill const& GetBackfill() const { return _backfill; }
+
+private:
+    void StartDelivery();
+    void LoadPendingRewards(std::vector<ObjectGuid::LowType> const& guids);
+    void DeliverRewards(QueryResult result);
+    static void SetRewardState(CharacterDatabaseTransaction trans, ChallengeModeReward const& reward, ChallengeModeRewardState state);
+    void UpdateBackfill(uint32 diff);
+    [[nodiscard]] bool BackfillsRewardType(ChallengeModeRewardType rewardType) const;
+    void LoadBackfillPage();
+    void QueueBackfillPage(QueryResult result);
+    void ReportBackfill(std::string const& message) const;
+    [[nodiscard]] bool IsUnrecordedGrant(ChallengeModeReward const& reward) const;
+    void ForgetUnrecordedGrant(ChallengeModeReward const& reward);
+    static bool DeliverReward(Player* player, ChallengeModeReward const& reward, CharacterDatabaseTransaction trans);
+    static void AnnounceTitle(Player* player, CharTitlesEntry const* titleInfo);
+
+    std::mutex _queueLock;
+    std::vector<ChallengeModeReward> _queuedRewards;
+    std::unordered_set<ObjectGuid::LowType> _pendingGuids;
+    // Titles, talents and achievements applied to online characters whose ledger commit failed, world thread only
+    std::unordered_map<ObjectGuid::LowType, std::vector<ChallengeModeReward>> _unrecordedGrants;
+
+    QueryCallbackProcessor _queryProcessor;
+    AsyncCallbackProcessor<TransactionCallback> _transactionProcessor;
+    uint32 _deliveryTimer = 0;
+    bool _deliveryInFlight = false;
+    ChallengeModeBackfill _backfill;
+};
+
+#define sChallengeModeRewards ChallengeModeRewards::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_REWARDS_H
@@ -0,0 +1,96 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_SETTINGS_H
+#define AZEROTHCORE_CHALLENGEMODES_SETTINGS_H
+
+// Player setting indexes of the module and the per-character copy the hooks read.
+// Only standard headers are included here, the copy does not depend on the core.
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+enum ChallengeModeSettings
+{
+    SETTING_HARDCORE           = 0,
+    SETTING_SEMI_HARDCORE      = 1,
+    SETTING_SELF_CRAFTED       = 2,
+    SETTING_ITEM_QUALITY_LEVEL = 3,
+    SETTING_SLOW_XP_GAIN       = 4,
+    SETTING_VERY_SLOW_XP_GAIN  = 5,
+    SETTING_QUEST_XP_ONLY      = 6,
+    SETTING_IRON_MAN           = 7,
+    HARDCORE_DEAD              = 8,
+    GEAR_VALIDATED_STAMP       = 9,
+    SETTING_SPEEDRUN           = 10,
+    HARDCORE_REVIVED           = 11  // Set by .challenge bulk revive for offline characters, cleared when they are revived at login
+};
+
+// Source of the module's player settings, also the key of the cached settings in Player::CustomData
+inline std::string const challengeModeSettingSource = "mod-challenge-modes";
+
+constexpr ChallengeModeSettings challengeModeList[] =
+{
+    SETTING_HARDCORE,
+    SETTING_SEMI_HARDCORE,
+    SETTING_SELF_CRAFTED,
+    SETTING_ITEM_QUALITY_LEVEL,
+    SETTING_SLOW_XP_GAIN,
+    SETTING_VERY_SLOW_XP_GAIN,
+    SETTING_QUEST_XP_ONLY,
+    SETTING_IRON_MAN,
+    SETTING_SPEEDRUN
+};
+
+constexpr uint8_t MAX_CHALLENGE_MODE_SETTING = HARDCORE_REVIVED + 1;
+
+constexpr uint32_t challengeModeMask(ChallengeModeSettings setting)
+{
+    return 1 << setting;
+}
+
+// Bits of every challenge in challengeModeList, the other setting indexes are character state
+constexpr uint32_t challengeModeListMask = []
+{
+    uint32_t mask = 0;
+    for (ChallengeModeSettings setting : challengeModeList)
+    {
+        mask |= challengeModeMask(setting);
+    }
+    return mask;
+}();
+
+// Levels with any title, talent, item or achievement reward, per challenge
+typedef std::array<std::bitset<256>, MAX_CHALLENGE_MODE_SETTING> ChallengeRewardLevels;
+
+// The module's player settings of one character. Player::GetPlayerSetting takes the source by value and copies the settings vector,
+// so every lookup allocates. The settings are copied here once the core loaded them and kept in step by ChallengeModes::setPlayerSetting.
+class ChallengeModePlayerSettings
+{
+public:
+    [[nodiscard]] uint32_t Get(uint8_t index) const { return index < MAX_CHALLENGE_MODE_SETTING ? _values[index] : 0; }
+    [[nodiscard]] bool IsSet(uint8_t index) const { return index < MAX_CHALLENGE_MODE_SETTING && (_setMask & (1 << index)); }
+    // Enabled challenges, see challengeModeMask
+    [[nodiscard]] uint32_t GetChallengeMask() const { return _setMask & challengeModeListMask; }
+
+    void Set(uint8_t index, uint32_t value)
+    {
+        if (index >= MAX_CHALLENGE_MODE_SETTING)
+        {
+            return;
+        }
+        _values[index] = value;
+        if (value)
+        {
+            _setMask |= 1 << index;
+        }
+        else
+        {
+            _setMask &= ~(1 << index);
+        }
+    }
+
+private:
+    std::array<uint32_t, MAX_CHALLENGE_MODE_SETTING> _values{};
+    uint32_t _setMask = 0;
+};
+
+#endif //AZEROTHCORE_CHALLENGEMODES_SETTINGS_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesSpeedrun.h"
+#include "ChallengeModesJournal.h"
+#include "ChallengeModesLeaderboard.h"
+#include "ObjectAccessor.h"
+#include <algorithm>
+
+void ChallengeModeTimingWheel::Schedule(ObjectGuid::LowType guid, uint64 expireTick)
+{
+    // The current slot was already processed, so the earliest deadline is the next tick
+    Timer& timer = _timers[guid];
+    timer.expireTick = std::max(expireTick, _tick + 1);
+    timer.generation = ++_nextGeneration;
+    Place(guid, timer);
+}
+
+void ChallengeModeTimingWheel::Cancel(ObjectGuid::LowType guid)
+{
+    _timers.erase(guid);
+}
+
+void ChallengeModeTimingWheel::Place(ObjectGuid::LowType guid, Timer const& timer)
+{
+    uint64 delta = timer.expireTick > _tick ? timer.expireTick - _tick : 0;
+    uint64 placeTick = timer.expireTick;
+    uint8 level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (uint64(1) << (WHEEL_SLOT_BITS * (level + 1))))
+    {
+        ++level;
+    }
+    // Deadlines beyond the last level wait in its farthest slot and are placed again from there
+    if (delta >= (uint64(1) << (WHEEL_SLOT_BITS * WHEEL_LEVELS)))
+    {
+        placeTick = _tick + (uint64(1) << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1;
+    }
+    uint32 slot = (std::max(placeTick, _tick) >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1);
+    _slots[level][slot].push_back({ guid, timer.generation });
+}
+
+void ChallengeModeTimingWheel::Tick(std::vector<ObjectGuid::LowType>& expired)
+{
+    ++_tick;
+
+    // Move the timers of a higher level slot down once every tick below it has passed, highest level first
+    // so timers cascaded from level 3 can continue to level 1 and 0 in the same tick
+    for (uint8 level = WHEEL_LEVELS - 1; level > 0; --level)
+    {
+        if (_tick & ((uint64(1) << (WHEEL_SLOT_BITS * level)) - 1))
+        {
+            continue;
+        }
+        std::vector<Entry> entries;
+        entries.swap(_slots[level][(_tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1)]);
+        for (Entry const& entry : entries)
+        {
+            auto itr = _timers.find(entry.guid);
+            if (itr != _timers.end() && itr->second.generation == entry.generation)
+            {
+                Place(entry.guid, itr->second);
+            }
+        }
+    }
+
+    std::vector<Entry>& slot = _slots[0][_tick & (WHEEL_SLOTS - 1)];
+    for (Entry const& entry : slot)
+    {
+        auto itr = _timers.find(entry.guid);
+        if (itr == _timers.end() || itr->second.generation != entry.generation)
+        {
+            continue;
+        }
+        expired.push_back(entry.guid);
+        _timers.erase(itr);
+    }
+    // Keep the capacity, slots are reused every 64 ticks
+    slot.clear();
+}
+
+ChallengeModeSpeedrun* ChallengeModeSpeedrun::instance()
+{
+    static ChallengeModeSpeedrun instance;
+    return &instance;
+}
+
+uint32 ChallengeModeSpeedrun::GetRemainingTime(Player* player)
+{
+    uint32 playedTime = player->GetTotalPlayedTime();
+    return playedTime < sChallengeModes->speedrunTimeLimit ? sChallengeModes->speedrunTimeLimit - playedTime : 0;
+}
+
+void ChallengeModeSpeedrun::Arm(Player* player)
+{
+    if (!sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player) || player->GetLevel() >= sChallengeModes->speedrunTargetLevel)
+    {
+        return;
+    }
+    uint32 remaining = GetRemainingTime(player);
+    std::lock_guard<std::mutex> guard(_lock);
+    _wheel.Schedule(player->GetGUID().GetCounter(), _wheel.GetTick() + remaining);
+}
+
+void ChallengeModeSpeedrun::Disarm(ObjectGuid::LowType guid)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _wheel.Cancel(guid);
+}
+
+void ChallengeModeSpeedrun::RecordSplit(Player* player, uint8 level)
+{
+    player->UpdatePlayerSetting(challengeModeSplitsSource, level, player->GetTotalPlayedTime());
+    if (level < sChallengeModes->speedrunTargetLevel)
+    {
+        return;
+    }
+    Disarm(player->GetGUID().GetCounter());
+    ChatHandler(player->GetSession()).SendSysMessage(Acore::StringFormat("你在规定时间内达到了 {} 级, 速通挑战完成!", level));
+}
+
+void ChallengeModeSpeedrun::Update(uint32 diff)
+{
+    _tickTimer += diff;
+    if (_tickTimer < IN_MILLISECONDS)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        for (; _tickTimer >= IN_MILLISECONDS; _tickTimer -= IN_MILLISECONDS)
+        {
+            _wheel.Tick(_expired);
+        }
+    }
+
+    // Expire outside the lock, it may arm the timer again
+    for (ObjectGuid::LowType guid : _expired)
+    {
+        Expire(guid);
+    }
+    _expired.clear();
+}
+
+void ChallengeModeSpeedrun::Expire(ObjectGuid::LowType guid)
+{
+    Player* player = ObjectAccessor::FindPlayerByLowGUID(guid);
+    if (!player || !sChallengeModes->challengeEnabledForPlayer(SETTING_SPEEDRUN, player) || player->GetLevel() >= sChallengeModes->speedrunTargetLevel)
+    {
+        return;
+    }
+    // Played time is updated by the player's own update, so it can trail the wheel by a moment
+    if (GetRemainingTime(player))
+    {
+        Arm(player);
+        return;
+    }
+
+    ChallengeModes::setPlayerSetting(player, SETTING_SPEEDRUN, 0);
+    sChallengeModeLeaderboard->UpdatePlayer(player);
+    sChallengeModeJournal->Record(JOURNAL_EVENT_SPEEDRUN_FAILED, player, SETTING_SPEEDRUN, player->GetTotalPlayedTime());
+    ChatHandler(player->GetSession()).SendSysMessage(Acore::StringFormat("你未能在规定时间内达到 {} 级, 速通挑战已结束。", sChallengeModes->speedrunTargetLevel));
+}
@@ -0,0 +1,79 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_SPEEDRUN_H
+#define AZEROTHCORE_CHALLENGEMODES_SPEEDRUN_H
+
+#include "ChallengeModes.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Split times of speedrun characters are stored as player settings of this source, indexed by level, in seconds of played time
+inline std::string const challengeModeSplitsSource = "mod-challenge-modes-splits";
+
+// Hierarchical timing wheel with one second ticks, level N slots span 64^N ticks so deadlines up to 64^4 seconds ahead
+// are placed directly and later ones are placed again when their slot comes up.
+// Scheduling and cancelling are O(1), a tick touches one slot plus a cascade every 64 ticks.
+class ChallengeModeTimingWheel
+{
+public:
+    static constexpr uint8 WHEEL_LEVELS    = 4;
+    static constexpr uint8 WHEEL_SLOT_BITS = 6;
+    static constexpr uint32 WHEEL_SLOTS    = 1 << WHEEL_SLOT_BITS;
+
+    void Schedule(ObjectGuid::LowType guid, uint64 expireTick);
+    void Cancel(ObjectGuid::LowType guid);
+    [[nodiscard]] bool IsScheduled(ObjectGuid::LowType guid) const { return _timers.count(guid) > 0; }
+    [[nodiscard]] uint64 GetTick() const { return _tick; }
+
+    // Advances the wheel by one tick and appends the timers that expired
+    void Tick(std::vector<ObjectGuid::LowType>& expired);
+
+private:
+    // Cancelled and rescheduled timers are left in their old slot and skipped by generation when the slot is processed
+    struct Entry
+    {
+        ObjectGuid::LowType guid;
+        uint32 generation;
+    };
+
+    struct Timer
+    {
+        uint64 expireTick;
+        uint32 generation;
+    };
+
+    void Place(ObjectGuid::LowType guid, Timer const& timer);
+
+    std::vector<Entry> _slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    std::unordered_map<ObjectGuid::LowType, Timer> _timers;
+    uint32 _nextGeneration = 0;
+    uint64 _tick = 0;
+};
+
+// Speedrun deadlines in played time. Only online characters have a timer, so logging out pauses the deadline like it pauses played time.
+class ChallengeModeSpeedrun
+{
+public:
+    static ChallengeModeSpeedrun* instance();
+
+    // Thread safe, may be called from map update threads
+    void Arm(Player* player);
+    void Disarm(ObjectGuid::LowType guid);
+    void RecordSplit(Player* player, uint8 level);
+
+    // World thread only
+    void Update(uint32 diff);
+
+    [[nodiscard]] static uint32 GetRemainingTime(Player* player);
+
+private:
+    void Expire(ObjectGuid::LowType guid);
+
+    std::mutex _lock;
+    ChallengeModeTimingWheel _wheel;
+    std::vector<ObjectGuid::LowType> _expired;
+    uint32 _tickTimer = 0;
+};
+
+#define sChallengeModeSpeedrun ChallengeModeSpeedrun::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_SPEEDRUN_H
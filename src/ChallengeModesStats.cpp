@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "ChallengeModesStats.h"
+#include "DatabaseEnv.h"
+#include "GameTime.h"
+#include <fstream>
+
+ChallengeModeStats* ChallengeModeStats::instance()
+{
+    static ChallengeModeStats instance;
+    return &instance;
+}
+
+bool ChallengeModeStats::Enabled() const
+{
+    return sChallengeModes->statsEnable;
+}
+
+ChallengeModeStatsShard& ChallengeModeStats::GetShard()
+{
+    static thread_local uint8 shardIndex = _nextShard.fetch_add(1, std::memory_order_relaxed) % STATS_SHARD_COUNT;
+    return _shards[shardIndex];
+}
+
+void ChallengeModeStats::RecordDeath(Player* player)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+    uint8 bracket = std::min<uint8>(player->GetLevel() / 10, STATS_LEVEL_BRACKETS - 1);
+    ChallengeModeStatsShard& shard = GetShard();
+    for (ChallengeModeSettings setting : challengeModeList)
+    {
+        if (sChallengeModes->challengeEnabledForPlayer(setting, player))
+        {
+            shard.deaths[setting][bracket].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ChallengeModeStats::RecordLevelUp(Player* player)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+    uint8 level = std::min<uint8>(player->GetLevel(), STATS_MAX_LEVEL);
+    uint16 bucket = statsTimeBucket(player->GetTotalPlayedTime());
+    ChallengeModeStatsShard& shard = GetShard();
+    for (ChallengeModeSettings setting : challengeModeList)
+    {
+        if (sChallengeModes->challengeEnabledForPlayer(setting, player))
+        {
+            shard.levelTimes[setting][level][bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ChallengeModeStats::RecordReward(uint8 mode, uint8 rewardType)
+{
+    if (Enabled() && mode < MAX_CHALLENGE_MODE_SETTING && rewardType < STATS_REWARD_TYPES)
+    {
+        GetShard().rewards[mode][rewardType].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ChallengeModeStats::RecordEquipDenied(ChallengeModeSettings setting)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+    GetShard().equipDenied[setting].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChallengeModeStats::RecordUseDenied(ChallengeModeSettings setting)
+{
+    if (!Enabled())
+    {
+        return;
+    }
+    GetShard().useDenied[setting].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChallengeModeStats::Update(uint32 diff)
+{
+    if (_flushTimer > diff)
+    {
+        _flushTimer -= diff;
+        return;
+    }
+    if (_flushTimer)
+    {
+        Flush(false);
+    }
+    _flushTimer = sChallengeModes->statsFlushInterval * MINUTE * IN_MILLISECONDS;
+}
+
+void ChallengeModeStats::Flush(bool direct)
+{
+    struct StatRow
+    {
+        uint8 mode;
+        uint8 stat;
+        uint8 key;
+        uint32 value;
+        uint32 bucket;
+    };
+    std::vector<StatRow> rows;
+
+    auto collect = [this](auto member) -> uint32
+    {
+        uint32 value = 0;
+        for (ChallengeModeStatsShard& shard : _shards)
+        {
+            value += member(shard).exchange(0, std::memory_order_relaxed);
+        }
+        return value;
+    };
+
+    for (ChallengeModeSettings setting : challengeModeList)
+    {
+        uint8 mode = setting;
+        for (uint8 bracket = 0; bracket < STATS_LEVEL_BRACKETS; ++bracket)
+        {
+            if (uint32 deaths = collect([mode, bracket](ChallengeModeStatsShard& shard) -> std::atomic<uint32>& { return shard.deaths[mode][bracket]; }))
+            {
+                rows.push_back({ mode, STAT_DEATHS, bracket, deaths, 0 });
+            }
+        }
+
+        for (uint8 level = 0; level <= STATS_MAX_LEVEL; ++level)
+        {
+            uint32 buckets[STATS_TIME_BUCKETS];
+            uint32 levelUps = 0;
+            for (uint16 bucket = 0; bucket < STATS_TIME_BUCKETS; ++bucket)
+            {
+                buckets[bucket] = collect([mode, level, bucket](ChallengeModeStatsShard& shard) -> std::atomic<uint32>& { return shard.levelTimes[mode][level][bucket]; });
+                levelUps += buckets[bucket];
+            }
+            if (!levelUps)
+            {
+                continue;
+            }
+            rows.push_back({ mode, STAT_LEVEL_UPS, level, levelUps, 0 });
+
+            // The bucket counts are written too, so medians can be computed over any range of flushes
+            for (uint16 bucket = 0; bucket < STATS_TIME_BUCKETS; ++bucket)
+            {
+                if (buckets[bucket])
+                {
+                    rows.push_back({ mode, STAT_LEVEL_TIME_BUCKET, level, buckets[bucket], statsTimeBucketStart(bucket) });
+                }
+            }
+
+            // The median of this flush is the middle of the bucket holding the middle level up, within 1/16 of the played time
+            uint32 seen = 0;
+            for (uint16 bucket = 0; bucket < STATS_TIME_BUCKETS; ++bucket)
+            {
+                seen += buckets[bucket];
+                if (seen * 2 >= levelUps)
+                {
+                    rows.push_back({ mode, STAT_LEVEL_TIME_MEDIAN, level, statsTimeBucketStart(bucket) + statsTimeBucketWidth(bucket) / 2, 0 });
+                    break;
+                }
+            }
+        }
+
+        for (uint8 rewardType = 0; rewardType < STATS_REWARD_TYPES; ++rewardType)
+        {
+            if (uint32 rewards = collect([mode, rewardType](ChallengeModeStatsShard& shard) -> std::atomic<uint32>& { return shard.rewards[mode][rewardType]; }))
+            {
+                rows.push_back({ mode, STAT_REWARDS, rewardType, rewards, 0 });
+            }
+        }
+
+        if (uint32 denied = collect([mode](ChallengeModeStatsShard& shard) -> std::atomic<uint32>& { return shard.equipDenied[mode]; }))
+        {
+            rows.push_back({ mode, STAT_EQUIP_DENIED, 0, denied, 0 });
+        }
+        if (uint32 denied = collect([mode](ChallengeModeStatsShard& shard) -> std::atomic<uint32>& { return shard.useDenied[mode]; }))
+        {
+            rows.push_back({ mode, STAT_USE_DENIED, 0, denied, 0 });
+        }
+    }
+
+    if (rows.empty())
+    {
+        return;
+    }
+
+    uint32 now = uint32(GameTime::GetGameTime().count());
+    std::string values;
+    for (StatRow const& row : rows)
+    {
+        if (!values.empty())
+        {
+            values += ',';
+        }
+        values += Acore::StringFormat("({}, {}, {}, {}, {}, {})", now, row.mode, row.stat, row.key, row.bucket, row.value);
+    }
+    std::string query = "INSERT INTO challenge_mode_stats (time, mode, stat, `key`, bucket, value) VALUES " + values;
+    if (direct)
+    {
+        CharacterDatabase.DirectExecute(query);
+    }
+    else
+    {
+        CharacterDatabase.Execute(query);
+    }
+
+    if (sChallengeModes->statsExportFile.empty())
+    {
+        return;
+    }
+    std::ofstream exportFile(ChallengeModes::getLogsPath(sChallengeModes->statsExportFile), std::ios::app);
+    if (!exportFile)
+    {
+        LOG_ERROR("mod-challenge-modes", "Failed to open challenge stats export file {}.", sChallengeModes->statsExportFile);
+        return;
+    }
+    for (StatRow const& row : rows)
+    {
+        exportFile << now << '\t' << ChallengeModes::getChallengeName(ChallengeModeSettings(row.mode)) << '\t' << uint32(row.stat) << '\t' << uint32(row.key) << '\t' << row.value << '\t' << row.bucket << '\n';
+    }
+}
+
+class ChallengeModes_StatsScript : public PlayerScript
+{
+public:
+    ChallengeModes_StatsScript() : PlayerScript("ChallengeModes_StatsScript") { }
+
+    void OnPlayerLevelChanged(Player* player, uint8 /*oldlevel*/) override
+    {
+        if (sChallengeModes->enabled())
+        {
+            sChallengeModeStats->RecordLevelUp(player);
+        }
+    }
+
+    void OnPlayerKilledByCreature(Creature* /*killer*/, Player* killed) override
+    {
+        if (sChallengeModes->enabled())
+        {
+            sChallengeModeStats->RecordDeath(killed);
+        }
+    }
+
+    void OnPlayerPVPKill(Player* /*killer*/, Player* killed) override
+    {
+        if (sChallengeModes->enabled())
+        {
+            sChallengeModeStats->RecordDeath(killed);
+        }
+    }
+};
+
+void AddSC_mod_challenge_modes_stats()
+{
+    new ChallengeModes_StatsScript();
+}
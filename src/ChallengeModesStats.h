@@ -0,0 +1,107 @@
+#ifndef AZEROTHCORE_CHALLENGEMODES_STATS_H
+#define AZEROTHCORE_CHALLENGEMODES_STATS_H
+
+#include "ChallengeModes.h"
+#include <atomic>
+
+enum ChallengeModeStat
+{
+    STAT_DEATHS              = 0,
+    STAT_LEVEL_UPS           = 1,
+    STAT_LEVEL_TIME_MEDIAN   = 2,
+    STAT_REWARDS             = 3,
+    STAT_EQUIP_DENIED        = 4,
+    STAT_USE_DENIED          = 5,
+    STAT_LEVEL_TIME_BUCKET   = 6
+};
+
+constexpr uint8 STATS_SHARD_COUNT    = 8;
+constexpr uint8 STATS_LEVEL_BRACKETS = 10; // Deaths are counted per 10 levels
+constexpr uint8 STATS_MAX_LEVEL      = DEFAULT_MAX_LEVEL;
+constexpr uint8 STATS_REWARD_TYPES   = 4;
+
+// Played time at level up is counted in log-linear buckets: below 8 seconds every second has its own bucket,
+// above that every power of two is split into 8 equal steps, so a bucket is at most 1/8 of its start wide
+constexpr uint8  STATS_TIME_STEPS_LOG2 = 3;
+constexpr uint8  STATS_TIME_STEPS      = 1 << STATS_TIME_STEPS_LOG2;
+constexpr uint8  STATS_TIME_MAX_LOG2   = 24; // Played times from 2^25 seconds on go to the last bucket
+constexpr uint16 STATS_TIME_BUCKETS    = STATS_TIME_STEPS * (STATS_TIME_MAX_LOG2 - STATS_TIME_STEPS_LOG2 + 2);
+
+constexpr uint16 statsTimeBucket(uint32 playedTime)
+{
+    if (playedTime < STATS_TIME_STEPS)
+    {
+        return uint16(playedTime);
+    }
+    uint8 log2 = 0;
+    while (log2 < 31 && (playedTime >> (log2 + 1)))
+    {
+        ++log2;
+    }
+    if (log2 > STATS_TIME_MAX_LOG2)
+    {
+        return STATS_TIME_BUCKETS - 1;
+    }
+    uint8 shift = log2 - STATS_TIME_STEPS_LOG2;
+    return uint16(STATS_TIME_STEPS * (shift + 1) + ((playedTime >> shift) & (STATS_TIME_STEPS - 1)));
+}
+
+// First played second counted in a bucket
+constexpr uint32 statsTimeBucketStart(uint16 bucket)
+{
+    if (bucket < STATS_TIME_STEPS)
+    {
+        return bucket;
+    }
+    uint8 shift = bucket / STATS_TIME_STEPS - 1;
+    return uint32(STATS_TIME_STEPS + bucket % STATS_TIME_STEPS) << shift;
+}
+
+constexpr uint32 statsTimeBucketWidth(uint16 bucket)
+{
+    return bucket < STATS_TIME_STEPS ? 1 : 1u << (bucket / STATS_TIME_STEPS - 1);
+}
+
+static_assert(statsTimeBucket(7) == 7 && statsTimeBucket(8) == 8 && statsTimeBucket(15) == 15 && statsTimeBucket(16) == 16, "Played time buckets must be contiguous");
+static_assert(statsTimeBucketStart(statsTimeBucket(1000)) <= 1000 && 1000 < statsTimeBucketStart(statsTimeBucket(1000)) + statsTimeBucketWidth(statsTimeBucket(1000)), "Played time bucket bounds");
+static_assert(statsTimeBucket(0xFFFFFFFF) == STATS_TIME_BUCKETS - 1, "Long played times go to the last bucket");
+
+// Counters of one shard, each map update thread increments its own shard so hooks never contend on a cache line
+struct alignas(64) ChallengeModeStatsShard
+{
+    std::atomic<uint32> deaths[MAX_CHALLENGE_MODE_SETTING][STATS_LEVEL_BRACKETS];
+    std::atomic<uint32> levelTimes[MAX_CHALLENGE_MODE_SETTING][STATS_MAX_LEVEL + 1][STATS_TIME_BUCKETS];
+    std::atomic<uint32> rewards[MAX_CHALLENGE_MODE_SETTING][STATS_REWARD_TYPES];
+    std::atomic<uint32> equipDenied[MAX_CHALLENGE_MODE_SETTING];
+    std::atomic<uint32> useDenied[MAX_CHALLENGE_MODE_SETTING];
+};
+
+// Aggregates gameplay telemetry from the player hooks and flushes it periodically into challenge_mode_stats
+class ChallengeModeStats
+{
+public:
+    static ChallengeModeStats* instance();
+
+    // Thread safe, may be called from map update threads
+    void RecordDeath(Player* player);
+    void RecordLevelUp(Player* player);
+    void RecordReward(uint8 mode, uint8 rewardType);
+    void RecordEquipDenied(ChallengeModeSettings setting);
+    void RecordUseDenied(ChallengeModeSettings setting);
+
+    // World thread only
+    void Update(uint32 diff);
+    void Flush(bool direct);
+
+private:
+    [[nodiscard]] bool Enabled() const;
+    ChallengeModeStatsShard& GetShard();
+
+    ChallengeModeStatsShard _shards[STATS_SHARD_COUNT] = {};
+    std::atomic<uint8> _nextShard{ 0 };
+    uint32 _flushTimer = 0;
+};
+
+#define sChallengeModeStats ChallengeModeStats::instance()
+
+#endif //AZEROTHCORE_CHALLENGEMODES_STATS_H
@@ -4,6 +4,12 @@
 
 // From SC
 void AddSC_mod_challenge_modes();
+void AddSC_mod_challenge_modes_rewards();
+void AddSC_mod_challenge_modes_commands();
+void AddSC_mod_challenge_modes_journal();
+void AddSC_mod_challenge_modes_stats();
+void AddSC_mod_challenge_modes_provenance();
+void AddSC_mod_challenge_modes_leaderboard();
 
 // Add all
 // cf. the naming convention https://github.com/azerothcore/azerothcore-wotlk/blob/master/doc/changelog/master.md#how-to-upgrade-4
@@ -11,4 +17,10 @@ void AddSC_mod_challenge_modes();
 void Addmod_challenge_modesScripts()
 {
     AddSC_mod_challenge_modes();
+    AddSC_mod_challenge_modes_rewards();
+    AddSC_mod_challenge_modes_commands();
+    AddSC_mod_challenge_modes_journal();
+    AddSC_mod_challenge_modes_stats();
+    AddSC_mod_challenge_modes_provenance();
+    AddSC_mod_challenge_modes_leaderboard();
 }
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// Offline decoder for the challenge event journal written by mod-challenge-modes.
+// Build: g++ -std=c++17 -O2 -o challenge_journal_decode tools/challenge_journal_decode.cpp
+// Usage: challenge_journal_decode <journal file> [character guid]
+
+#include "../src/ChallengeModesJournalFormat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <vector>
+
+static char const* modeName(uint8_t mode)
+{
+    // Indexes 8 and 9 are character state, not challenges
+    static char const* const names[] = { "Hardcore", "SemiHardcore", "SelfCrafted", "ItemQualityLevel", "SlowXpGain", "VerySlowXpGain", "QuestXpOnly", "IronMan", nullptr, nullptr, "Speedrun" };
+    if (mode < sizeof(names) / sizeof(names[0]) && names[mode])
+    {
+        return names[mode];
+    }
+    return mode == CHALLENGE_JOURNAL_NO_MODE ? "-" : "unknown";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <journal file> [character guid]\n", argv[0]);
+        return 1;
+    }
+    bool filterGuid = argc > 2;
+    uint32_t guid = filterGuid ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : 0;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    ChallengeJournalHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        std::fprintf(stderr, "Failed to read journal header from %s\n", argv[1]);
+        return 1;
+    }
+    if (header.magic != CHALLENGE_JOURNAL_MAGIC || header.version != CHALLENGE_JOURNAL_VERSION || header.recordSize != sizeof(ChallengeJournalRecord))
+    {
+        std::fprintf(stderr, "%s is not a challenge journal of version %u\n", argv[1], CHALLENGE_JOURNAL_VERSION);
+        return 1;
+    }
+
+    std::vector<ChallengeJournalRecord> records;
+    ChallengeJournalRecord record{};
+    for (uint32_t i = 0; i < header.capacity && file.read(reinterpret_cast<char*>(&record), sizeof(record)); ++i)
+    {
+        if (record.sequence && (!filterGuid || record.guid == guid))
+        {
+            records.push_back(record);
+        }
+    }
+    std::sort(records.begin(), records.end(), [](ChallengeJournalRecord const& left, ChallengeJournalRecord const& right)
+    {
+        return left.sequence < right.sequence;
+    });
+
+    std::printf("sequence,time,guid,event,mode,level,value1,value2,value3\n");
+    for (ChallengeJournalRecord const& entry : records)
+    {
+        char timeStr[32] = "";
+        std::time_t time = entry.time;
+        if (std::tm* utc = std::gmtime(&time))
+        {
+            std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%SZ", utc);
+        }
+        std::printf("%llu,%s,%u,%s,%s,%u,%u,%u,%u\n", static_cast<unsigned long long>(entry.sequence), timeStr, entry.guid,
+            challengeJournalEventName(entry.event), modeName(entry.mode), entry.level, entry.value1, entry.value2, entry.value3);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// Checks that a level up without rewards does not allocate and a level up with a reward allocates a bounded amount.
+// Runs the module's own level up hooks, built against core_stub.h: the challenge scripts, the rewards, the journal, the stats and the leaderboard.
+// Build and run: make -C tools/test test
+// Usage: challenge_settings_alloc_test, exits with 1 when a check fails
+
+#include "ChallengeModes.h"
+#include "ChallengeModesSettings.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+void Addmod_challenge_modesScripts();
+
+// Only the test thread is counted, the journal and leaderboard threads allocate on their own
+static thread_local bool countAllocations = false;
+static thread_local size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    if (countAllocations)
+    {
+        ++allocations;
+    }
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static int failures = 0;
+
+static void check(bool condition, char const* description)
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "FAILED: %s\n", description);
+        ++failures;
+    }
+}
+
+// Runs every registered level up hook like ScriptMgr does and returns how many allocations they made
+static size_t levelUp(Player* player, uint8 level)
+{
+    uint8 oldLevel = player->GetLevel();
+    player->SetLevel(level);
+    allocations = 0;
+    countAllocations = true;
+    for (PlayerScript* script : RegisteredPlayerScripts())
+    {
+        script->OnPlayerLevelChanged(player, oldLevel);
+    }
+    countAllocations = false;
+    return allocations;
+}
+
+int main()
+{
+    sConfigMgr->SetOption("ChallengeModes.Enable", "1");
+    sConfigMgr->SetOption("Hardcore.TitleRewards", "10 123");
+    sConfigMgr->SetOption("Hardcore.DisableLevel", "60");
+    sConfigMgr->SetOption("ChallengeModes.Leaderboard.Enable", "1");
+    sConfigMgr->SetOption("LogsDir", "build");
+    sConfigMgr->SetOption("ChallengeModes.Journal.Capacity", "1024");
+
+    Addmod_challenge_modesScripts();
+    for (WorldScript* script : RegisteredWorldScripts())
+    {
+        script->OnBeforeConfigLoad(false);
+    }
+    for (WorldScript* script : RegisteredWorldScripts())
+    {
+        script->OnStartup();
+    }
+
+    Player player(1, CLASS_WARRIOR, 1);
+    ObjectAccessor::GetPlayers()[player.GetGUID()] = &player;
+
+    check(ChallengeModes::getPlayerData(&player) == nullptr, "the settings are not cached before the character loaded");
+    for (PlayerScript* script : RegisteredPlayerScripts())
+    {
+        script->OnPlayerLoadFromDB(&player);
+    }
+    check(ChallengeModes::getPlayerData(&player) != nullptr, "loading the character caches the settings");
+
+    ChallengeModes::setPlayerSetting(&player, SETTING_HARDCORE, 1);
+    ChallengeModes::setPlayerSetting(&player, SETTING_SELF_CRAFTED, 1);
+    check(ChallengeModes::getPlayerSettings(&player).GetChallengeMask() == (challengeModeMask(SETTING_HARDCORE) | challengeModeMask(SETTING_SELF_CRAFTED)),
+        "setting a challenge updates the cache");
+    check(player.GetPlayerSetting(challengeModeSettingSource, SETTING_HARDCORE).value == 1, "setting a challenge updates the player's settings");
+
+    size_t before = allocations;
+    countAllocations = true;
+    volatile uint32 value = player.GetPlayerSetting(challengeModeSettingSource, SETTING_HARDCORE).value;
+    countAllocations = false;
+    (void)value;
+    check(allocations > before, "reading the player's settings allocates, so the counter works and the cache is needed");
+
+    // The first level up adds the character to the leaderboard, which allocates once
+    levelUp(&player, 2);
+
+    check(levelUp(&player, 3) == 0, "a level up without rewards does not allocate");
+    size_t rewardAllocations = levelUp(&player, 10);
+    check(rewardAllocations > 0, "a level up with a reward queues it");
+    check(rewardAllocations <= 8, "a level up with a reward allocates a bounded amount");
+    check(levelUp(&player, 11) == 0, "a level up after a reward does not allocate");
+
+    levelUp(&player, 60);
+    check(!ChallengeModes::getPlayerSettings(&player).IsSet(SETTING_HARDCORE), "reaching the disable level disables the challenge");
+    check(ChallengeModes::getPlayerSettings(&player).IsSet(SETTING_SELF_CRAFTED), "other challenges stay enabled");
+
+    for (WorldScript* script : RegisteredWorldScripts())
+    {
+        script->OnShutdown();
+    }
+
+    if (failures)
+    {
+        return 1;
+    }
+    std::printf("All checks passed.\n");
+    return 0;
+}
@@ -0,0 +1,695 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef AZEROTHCORE_CHALLENGEMODES_CORE_STUB_H
+#define AZEROTHCORE_CHALLENGEMODES_CORE_STUB_H
+
+// The parts of the core the module uses, enough to build and link the module's sources into tools/test without the core.
+// Players keep their settings like the core does, the database never answers and every other call does nothing.
+// tools/Makefile generates a header for every core header the module includes that only includes this one.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t int8;
+typedef int32_t int32;
+typedef int64_t int64;
+
+template<typename T> using Optional = std::optional<T>;
+typedef std::chrono::seconds Seconds;
+
+namespace Acore
+{
+    template<typename... Args>
+    std::string StringFormat(std::string_view format, Args&&... /*args*/) { return std::string(format); }
+
+    namespace Time
+    {
+        inline std::string TimeToHumanReadable(Seconds /*time*/) { return {}; }
+    }
+}
+
+#define LOG_ERROR(filter, ...) ((void)0)
+#define LOG_WARN(filter, ...) ((void)0)
+#define LOG_INFO(filter, ...) ((void)0)
+
+inline bool StringEqualI(std::string_view a, std::string_view b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) { return std::tolower(x) == std::tolower(y); });
+}
+
+enum class HighGuid
+{
+    Player = 0,
+    Item   = 1
+};
+
+class ObjectGuid
+{
+public:
+    typedef uint32 LowType;
+
+    ObjectGuid() = default;
+    template<HighGuid high>
+    static ObjectGuid Create(LowType counter) { ObjectGuid guid; guid._raw = (uint64(high) << 32) | counter; return guid; }
+
+    [[nodiscard]] LowType GetCounter() const { return LowType(_raw); }
+    [[nodiscard]] uint64 GetRawValue() const { return _raw; }
+    bool operator==(ObjectGuid const& other) const { return _raw == other._raw; }
+    bool operator!=(ObjectGuid const& other) const { return _raw != other._raw; }
+
+    static ObjectGuid const Empty;
+
+private:
+    uint64 _raw = 0;
+};
+inline ObjectGuid const ObjectGuid::Empty;
+
+template<>
+struct std::hash<ObjectGuid>
+{
+    size_t operator()(ObjectGuid const& guid) const { return std::hash<uint64>()(guid.GetRawValue()); }
+};
+
+// Database
+
+struct Field
+{
+    template<typename T> T Get() const { return T(); }
+    [[nodiscard]] bool IsNull() const { return true; }
+};
+
+struct ResultSet
+{
+    Field* Fetch() { return &_field; }
+    bool NextRow() { return false; }
+    [[nodiscard]] uint64 GetRowCount() const { return 0; }
+
+    Field _field;
+};
+typedef std::shared_ptr<ResultSet> QueryResult;
+
+struct TransactionBase
+{
+    template<typename... Args>
+    void Append(std::string_view /*sql*/, Args&&... /*args*/) { }
+};
+typedef std::shared_ptr<TransactionBase> CharacterDatabaseTransaction;
+
+struct QueryCallback
+{
+    QueryCallback&& WithCallback(std::function<void(QueryResult)>&& /*callback*/) { return std::move(*this); }
+};
+
+struct TransactionCallback
+{
+    void AfterComplete(std::function<void(bool)> /*callback*/) & { }
+};
+
+template<typename T>
+class AsyncCallbackProcessor
+{
+public:
+    T& AddCallback(T&& callback) { _last = std::move(callback); return _last; }
+    void ProcessReadyCallbacks() { }
+
+private:
+    T _last;
+};
+typedef AsyncCallbackProcessor<QueryCallback> QueryCallbackProcessor;
+
+struct DatabaseWorkerPool
+{
+    CharacterDatabaseTransaction BeginTransaction() { return std::make_shared<TransactionBase>(); }
+    TransactionCallback AsyncCommitTransaction(CharacterDatabaseTransaction /*trans*/) { return {}; }
+    void CommitTransaction(CharacterDatabaseTransaction /*trans*/) { }
+    void DirectCommitTransaction(CharacterDatabaseTransaction /*trans*/) { }
+    QueryCallback AsyncQuery(std::string_view /*sql*/) { return {}; }
+    template<typename... Args>
+    QueryResult Query(std::string_view /*sql*/, Args&&... /*args*/) { return nullptr; }
+    template<typename... Args>
+    void Execute(std::string_view /*sql*/, Args&&... /*args*/) { }
+    template<typename... Args>
+    void DirectExecute(std::string_view /*sql*/, Args&&... /*args*/) { }
+    void EscapeString(std::string& /*str*/) { }
+};
+inline DatabaseWorkerPool CharacterDatabase;
+inline DatabaseWorkerPool WorldDatabase;
+
+// DBC stores, always empty
+
+struct CharTitlesEntry
+{
+    char const* nameMale[16];
+    char const* nameFemale[16];
+};
+
+struct AchievementEntry { };
+
+struct MapEntry
+{
+    [[nodiscard]] bool IsDungeon() const { return false; }
+    [[nodiscard]] bool IsRaid() const { return false; }
+    [[nodiscard]] bool IsBattlegroundOrArena() const { return false; }
+};
+
+template<typename T>
+struct DBCStorage
+{
+    T const* LookupEntry(uint32 /*id*/) const { return nullptr; }
+    [[nodiscard]] uint32 GetNumRows() const { return 0; }
+};
+inline DBCStorage<CharTitlesEntry> sCharTitlesStore;
+inline DBCStorage<AchievementEntry> sAchievementStore;
+inline DBCStorage<MapEntry> sMapStore;
+
+enum LocaleConstant { LOCALE_enUS = 0 };
+enum Gender { GENDER_MALE = 0 };
+enum EnchantmentSlot { };
+enum InventoryResult { };
+enum AtLoginFlags { AT_LOGIN_RESURRECT = 0x200 };
+enum MailMessageType { MAIL_NORMAL = 0, MAIL_AUCTION = 2, MAIL_CREATURE = 3 };
+enum MailCheckMask { MAIL_CHECK_MASK_RETURNED = 2, MAIL_CHECK_MASK_COPIED = 4 };
+enum AuctionAction { AUCTION_WON = 1 };
+
+enum
+{
+    CLASS_WARRIOR = 1, CLASS_DEATH_KNIGHT = 6,
+    EQUIPMENT_SLOT_END = 19, INVENTORY_SLOT_BAG_0 = 255, NULL_BAG = 0, NULL_SLOT = 255, EQUIP_ERR_OK = 0,
+    ITEM_QUALITY_NORMAL = 1, ITEM_FIELD_CREATOR = 10, ITEM_CLASS_CONSUMABLE = 0,
+    ITEM_SUBCLASS_POTION = 1, ITEM_SUBCLASS_ELIXIR = 2, ITEM_SUBCLASS_FLASK = 3, ITEM_SUBCLASS_FOOD = 5,
+    XPSOURCE_KILL = 0, XPSOURCE_QUEST = 1, XPSOURCE_QUEST_DF = 2, XPSOURCE_EXPLORE = 3, XPSOURCE_BATTLEGROUND = 4,
+    SPELL_EFFECT_TRADE_SKILL = 47, SPELL_AURA_PERIODIC_TRIGGER_SPELL = 23, SPEC_MASK_ALL = 255,
+    GOSSIP_ICON_CHAT = 0, MAIL_STATIONERY_GM = 61,
+    SEC_PLAYER = 0, SEC_GAMEMASTER = 2, SEC_ADMINISTRATOR = 3,
+    DEFAULT_MAX_LEVEL = 80, STRONG_MAX_LEVEL = 255, MAX_LOCALES = 9, LANG_PLAYER_NOT_FOUND = 205,
+    MINUTE = 60, HOUR = 3600, IN_MILLISECONDS = 1000
+};
+
+// Objects
+
+struct ItemSpell { uint32 SpellId = 0; };
+
+struct ItemTemplate
+{
+    [[nodiscard]] bool HasSignature() const { return false; }
+    uint32 ItemId = 0;
+    uint32 Class = 0;
+    uint32 SubClass = 0;
+    uint32 Quality = 0;
+    ItemSpell Spells[5];
+    std::string Name1;
+};
+
+struct Item
+{
+    static Item* CreateItem(uint32 /*entry*/, uint32 /*count*/, void const* /*player*/ = nullptr) { return nullptr; }
+    [[nodiscard]] ItemTemplate const* GetTemplate() const { return &_template; }
+    [[nodiscard]] ObjectGuid GetGUID() const { return _guid; }
+    [[nodiscard]] ObjectGuid GetOwnerGUID() const { return _owner; }
+    [[nodiscard]] ObjectGuid GetGuidValue(uint32 /*index*/) const { return ObjectGuid::Empty; }
+    [[nodiscard]] uint32 GetEntry() const { return _template.ItemId; }
+    [[nodiscard]] bool IsEquipped() const { return false; }
+    [[nodiscard]] uint8 GetSlot() const { return 0; }
+    void SaveToDB(CharacterDatabaseTransaction /*trans*/) { }
+    void DeleteFromInventoryDB(CharacterDatabaseTransaction /*trans*/) { }
+
+    ItemTemplate _template;
+    ObjectGuid _guid;
+    ObjectGuid _owner;
+};
+typedef std::vector<uint32> ItemPosCountVec;
+
+class DataMap
+{
+public:
+    class Base
+    {
+    public:
+        virtual ~Base() = default;
+    };
+
+    template<class T>
+    T* Get(std::string const& key) const
+    {
+        auto itr = _container.find(key);
+        return itr != _container.end() ? dynamic_cast<T*>(itr->second.get()) : nullptr;
+    }
+
+    template<class T>
+    T* GetDefault(std::string const& key)
+    {
+        if (T* value = Get<T>(key))
+        {
+            return value;
+        }
+        T* value = new T();
+        _container[key].reset(value);
+        return value;
+    }
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<Base>> _container;
+};
+
+struct PlayerSetting
+{
+    uint32 value = 0;
+};
+
+class Player;
+struct Group;
+struct TradeData;
+struct AuctionEntry;
+struct Unit
+{
+    DataMap CustomData;
+};
+
+struct Pet
+{
+    void GivePetXP(uint32 /*xp*/) { }
+};
+
+struct Creature
+{
+    [[nodiscard]] uint32 GetEntry() const { return 0; }
+};
+
+class WorldSession
+{
+public:
+    explicit WorldSession(Player* player) : _player(player) { }
+    [[nodiscard]] Player* GetPlayer() const { return _player; }
+    [[nodiscard]] uint32 GetSecurity() const { return SEC_PLAYER; }
+    void KickPlayer(std::string const& /*reason*/) { }
+
+private:
+    Player* _player;
+};
+
+class Player : public Unit
+{
+public:
+    Player(ObjectGuid::LowType guid, uint8 playerClass, uint8 level) : _guid(ObjectGuid::Create<HighGuid::Player>(guid)), _class(playerClass), _level(level), _session(this) { }
+
+    // Copies the settings like the core does
+    PlayerSetting GetPlayerSetting(std::string source, uint8 index)
+    {
+        auto itr = _settings.find(source);
+        if (itr == _settings.end() || itr->second.size() <= index)
+        {
+            UpdatePlayerSetting(source, index, 0);
+            return GetPlayerSetting(source, index);
+        }
+        std::vector<PlayerSetting> settings = itr->second;
+        return settings[index];
+    }
+
+    void UpdatePlayerSetting(std::string source, uint8 index, uint32 value)
+    {
+        std::vector<PlayerSetting>& settings = _settings[source];
+        if (settings.size() <= index)
+        {
+            settings.resize(index + 1);
+        }
+        settings[index].value = value;
+    }
+
+    [[nodiscard]] ObjectGuid GetGUID() const { return _guid; }
+    [[nodiscard]] std::string const& GetName() const { return _name; }
+    [[nodiscard]] uint8 GetLevel() const { return _level; }
+    void SetLevel(uint8 level) { _level = level; }
+    [[nodiscard]] uint8 getClass() const { return _class; }
+    [[nodiscard]] uint8 getGender() const { return GENDER_MALE; }
+    [[nodiscard]] WorldSession* GetSession() const { return const_cast<WorldSession*>(&_session); }
+    [[nodiscard]] Pet* GetPet() const { return nullptr; }
+    [[nodiscard]] Group* GetGroup() const { return nullptr; }
+    [[nodiscard]] TradeData* GetTradeData() const { return nullptr; }
+    [[nodiscard]] uint32 GetTotalPlayedTime() const { return 0; }
+    [[nodiscard]] uint32 GetMapId() const { return 0; }
+    [[nodiscard]] bool IsAlive() const { return true; }
+    [[nodiscard]] bool IsInWorld() const { return true; }
+    [[nodiscard]] bool HasAtLoginFlag(uint32 /*flag*/) const { return false; }
+    [[nodiscard]] bool HasTitle(CharTitlesEntry const* /*title*/) const { return false; }
+    [[nodiscard]] bool HasAchieved(uint32 /*achievementId*/) const { return false; }
+
+    void SetTitle(CharTitlesEntry const* /*title*/, bool /*lost*/ = false) { }
+    void RewardExtraBonusTalentPoints(uint32 /*points*/) { }
+    void CompletedAchievement(AchievementEntry const* /*achievement*/) { }
+    void SendItemRetrievalMail(std::vector<std::pair<uint32, uint32>> /*items*/) { }
+    void SetFreeTalentPoints(uint32 /*points*/) { }
+    void removeSpell(uint32 /*spellId*/, uint8 /*specMask*/, bool /*onlyTemporary*/) { }
+    void SetMoney(uint32 /*money*/) { }
+    void KillPlayer() { }
+    void ResurrectPlayer(float /*restorePercent*/, bool /*applySickness*/ = false) { }
+    void SpawnCorpseBones(bool /*triggerSave*/ = true) { }
+    void SaveToDB(CharacterDatabaseTransaction /*trans*/, bool /*create*/, bool /*logout*/) { }
+    void SaveToDB(bool /*create*/, bool /*logout*/) { }
+    static void OfflineResurrect(ObjectGuid const& /*guid*/, CharacterDatabaseTransaction /*trans*/) { }
+
+    [[nodiscard]] Item* GetItemByPos(uint8 /*bag*/, uint8 /*slot*/) const { return nullptr; }
+    [[nodiscard]] Item* GetItemByGuid(ObjectGuid /*guid*/) const { return nullptr; }
+    uint8 CanStoreItem(uint8 /*bag*/, uint8 /*slot*/, ItemPosCountVec& /*dest*/, Item* /*item*/, bool /*swap*/) const { return EQUIP_ERR_OK; }
+    Item* StoreItem(ItemPosCountVec& /*dest*/, Item* item, bool /*update*/) { return item; }
+    void RemoveItem(uint8 /*bag*/, uint8 /*slot*/, bool /*update*/) { }
+    void MoveItemFromInventory(uint8 /*bag*/, uint8 /*slot*/, bool /*update*/) { }
+    void DestroyItem(uint8 /*bag*/, uint8 /*slot*/, bool /*update*/) { }
+
+private:
+    ObjectGuid _guid;
+    uint8 _class;
+    uint8 _level;
+    std::string _name = "Test";
+    WorldSession _session;
+    std::unordered_map<std::string, std::vector<PlayerSetting>> _settings;
+};
+
+struct TradeData
+{
+    [[nodiscard]] Player* GetTrader() const { return nullptr; }
+};
+
+namespace ObjectAccessor
+{
+    inline std::unordered_map<ObjectGuid, Player*>& GetPlayers()
+    {
+        static std::unordered_map<ObjectGuid, Player*> players;
+        return players;
+    }
+
+    inline Player* FindPlayerByLowGUID(ObjectGuid::LowType guid)
+    {
+        auto itr = GetPlayers().find(ObjectGuid::Create<HighGuid::Player>(guid));
+        return itr != GetPlayers().end() ? itr->second : nullptr;
+    }
+
+    inline Player* FindConnectedPlayer(ObjectGuid guid)
+    {
+        auto itr = GetPlayers().find(guid);
+        return itr != GetPlayers().end() ? itr->second : nullptr;
+    }
+}
+
+namespace GameTime
+{
+    inline Seconds GetGameTime()
+    {
+        return std::chrono::duration_cast<Seconds>(std::chrono::system_clock::now().time_since_epoch());
+    }
+}
+
+namespace lfg
+{
+    typedef std::set<uint32> LfgDungeonSet;
+}
+
+// Chat and gossip
+
+class ChatHandler
+{
+public:
+    explicit ChatHandler(WorldSession* session) : _session(session) { }
+    void SendSysMessage(std::string_view /*message*/) { }
+    void SendSysMessage(uint32 /*entry*/) { }
+    template<typename... Args>
+    void PSendSysMessage(std::string_view /*format*/, Args&&... /*args*/) { }
+    [[nodiscard]] std::string GetNameLink(Player* player) const { return player->GetName(); }
+    [[nodiscard]] LocaleConstant GetSessionDbcLocale() const { return LOCALE_enUS; }
+    WorldSession* GetSession() { return _session; }
+    void SetSentErrorMessage(bool /*value*/) { }
+
+private:
+    WorldSession* _session;
+};
+
+struct GameObject
+{
+    [[nodiscard]] ObjectGuid GetGUID() const { return ObjectGuid::Empty; }
+};
+
+inline void AddGossipItemFor(Player* /*player*/, uint32 /*icon*/, std::string const& /*text*/, uint32 /*sender*/, uint32 /*action*/) { }
+inline void SendGossipMenuFor(Player* /*player*/, uint32 /*npcTextId*/, ObjectGuid /*guid*/) { }
+inline void CloseGossipMenuFor(Player* /*player*/) { }
+
+struct PlayerIdentifier
+{
+    static std::optional<PlayerIdentifier> FromTargetOrSelf(ChatHandler* /*handler*/) { return std::nullopt; }
+    [[nodiscard]] ObjectGuid GetGUID() const { return ObjectGuid::Empty; }
+    [[nodiscard]] std::string const& GetName() const { return _name; }
+    [[nodiscard]] Player* GetConnectedPlayer() const { return nullptr; }
+    [[nodiscard]] bool IsConnected() const { return false; }
+
+    std::string _name;
+};
+
+namespace Acore::ChatCommands
+{
+    enum class Console
+    {
+        No,
+        Yes
+    };
+
+    struct ChatCommandBuilder
+    {
+        template<typename Handler>
+        ChatCommandBuilder(char const* /*name*/, Handler /*handler*/, uint32 /*security*/, Console /*console*/) { }
+        ChatCommandBuilder(char const* /*name*/, std::vector<ChatCommandBuilder> const& /*subCommands*/) { }
+    };
+    typedef std::vector<ChatCommandBuilder> ChatCommandTable;
+}
+
+// Mail
+
+class MailSender
+{
+public:
+    MailSender(MailMessageType type, uint32 senderId) : _type(type), _senderId(senderId) { }
+    MailSender(Player* sender, uint32 /*stationery*/) : _type(MAIL_NORMAL), _senderId(sender->GetGUID().GetCounter()) { }
+    [[nodiscard]] MailMessageType GetMailMessageType() const { return _type; }
+    [[nodiscard]] uint32 GetSenderId() const { return _senderId; }
+
+private:
+    MailMessageType _type;
+    uint32 _senderId;
+};
+
+class MailReceiver
+{
+public:
+    MailReceiver(ObjectGuid::LowType guid) : _player(nullptr), _guid(guid) { }
+    MailReceiver(Player* player) : _player(player), _guid(player->GetGUID().GetCounter()) { }
+    MailReceiver(Player* player, ObjectGuid::LowType guid) : _player(player), _guid(guid) { }
+    [[nodiscard]] Player* GetPlayer() const { return _player; }
+    [[nodiscard]] ObjectGuid::LowType GetPlayerGUIDLow() const { return _guid; }
+
+private:
+    Player* _player;
+    ObjectGuid::LowType _guid;
+};
+
+class MailDraft
+{
+public:
+    MailDraft(std::string subject, std::string body) : _subject(std::move(subject)), _body(std::move(body)) { }
+    MailDraft& AddItem(Item* item) { _items[item->GetGUID().GetCounter()] = item; return *this; }
+    std::map<uint32, Item*>& GetItems() { return _items; }
+    [[nodiscard]] std::string const& GetSubject() const { return _subject; }
+    void SendMailTo(CharacterDatabaseTransaction /*trans*/, MailReceiver const& /*receiver*/, MailSender const& /*sender*/, uint32 /*checked*/ = 0) { }
+
+private:
+    std::string _subject;
+    std::string _body;
+    std::map<uint32, Item*> _items;
+};
+
+// Config and spells
+
+class ConfigMgr
+{
+public:
+    template<typename T>
+    T GetOption(std::string const& name, T const& def) const
+    {
+        auto itr = _options.find(name);
+        if (itr == _options.end())
+        {
+            return def;
+        }
+        if constexpr (std::is_same_v<T, std::string>)
+        {
+            return itr->second;
+        }
+        else
+        {
+            T value = def;
+            std::istringstream(itr->second) >> value;
+            return value;
+        }
+    }
+
+    void SetOption(std::string const& name, std::string const& value) { _options[name] = value; }
+
+private:
+    std::unordered_map<std::string, std::string> _options;
+};
+inline ConfigMgr configMgr;
+inline ConfigMgr* sConfigMgr = &configMgr;
+
+struct SpellEffectInfo
+{
+    uint32 Effect = 0;
+    uint32 ApplyAuraName = 0;
+};
+
+struct SpellInfo
+{
+    SpellEffectInfo Effects[3];
+};
+
+struct SpellMgr
+{
+    SpellInfo const* GetSpellInfo(uint32 /*spellId*/) { return nullptr; }
+};
+inline SpellMgr spellMgr;
+inline SpellMgr* sSpellMgr = &spellMgr;
+
+// Scripts register themselves like in the core, so tests can run the hooks the way ScriptMgr does
+
+class PlayerScript;
+class WorldScript;
+inline std::vector<PlayerScript*>& RegisteredPlayerScripts()
+{
+    static std::vector<PlayerScript*> scripts;
+    return scripts;
+}
+inline std::vector<WorldScript*>& RegisteredWorldScripts()
+{
+    static std::vector<WorldScript*> scripts;
+    return scripts;
+}
+
+class PlayerScript
+{
+public:
+    explicit PlayerScript(char const* /*name*/) { RegisteredPlayerScripts().push_back(this); }
+    virtual ~PlayerScript() = default;
+
+    virtual void OnPlayerGiveXP(Player* /*player*/, uint32& /*amount*/, Unit* /*victim*/, uint8 /*xpSource*/) { }
+    virtual void OnPlayerLevelChanged(Player* /*player*/, uint8 /*oldLevel*/) { }
+    virtual void OnPlayerLogin(Player* /*player*/) { }
+    virtual void OnPlayerLogout(Player* /*player*/) { }
+    virtual void OnPlayerLoadFromDB(Player* /*player*/) { }
+    virtual void OnPlayerSave(Player* /*player*/) { }
+    virtual void OnPlayerDelete(ObjectGuid /*guid*/, uint32 /*accountId*/) { }
+    virtual void OnPlayerReleasedGhost(Player* /*player*/) { }
+    virtual void OnPlayerPVPKill(Player* /*killer*/, Player* /*killed*/) { }
+    virtual void OnPlayerKilledByCreature(Creature* /*killer*/, Player* /*killed*/) { }
+    virtual void OnPlayerResurrect(Player* /*player*/, float /*restorePercent*/, bool /*applySickness*/) { }
+    virtual void OnPlayerTalentsReset(Player* /*player*/, bool /*noCost*/) { }
+    virtual void OnPlayerLearnSpell(Player* /*player*/, uint32 /*spellId*/) { }
+    virtual bool OnPlayerCanEquipItem(Player* /*player*/, uint8 /*slot*/, uint16& /*dest*/, Item* /*item*/, bool /*swap*/, bool /*notLoading*/) { return true; }
+    virtual bool OnPlayerCanApplyEnchantment(Player* /*player*/, Item* /*item*/, EnchantmentSlot /*slot*/, bool /*apply*/, bool /*applyDur*/, bool /*ignoreCondition*/) { return true; }
+    virtual bool OnPlayerCanUseItem(Player* /*player*/, ItemTemplate const* /*proto*/, InventoryResult& /*result*/) { return true; }
+    virtual bool OnPlayerCanGroupInvite(Player* /*player*/, std::string& /*memberName*/) { return true; }
+    virtual bool OnPlayerCanGroupAccept(Player* /*player*/, Group* /*group*/) { return true; }
+    virtual bool OnPlayerBeforeTeleport(Player* /*player*/, uint32 /*mapId*/, float /*x*/, float /*y*/, float /*z*/, float /*orientation*/, uint32 /*options*/, Unit* /*target*/) { return true; }
+    virtual bool OnPlayerCanJoinLfg(Player* /*player*/, uint8 /*roles*/, lfg::LfgDungeonSet& /*dungeons*/, std::string const& /*comment*/) { return true; }
+    virtual bool OnPlayerCanInitTrade(Player* /*player*/, Player* /*target*/) { return true; }
+    virtual bool OnPlayerCanSetTradeItem(Player* /*player*/, Item* /*tradedItem*/, uint8 /*tradeSlot*/) { return true; }
+    virtual bool OnPlayerCanSendMail(Player* /*player*/, ObjectGuid /*receiverGuid*/, ObjectGuid /*mailbox*/, std::string& /*subject*/, std::string& /*body*/, uint32 /*money*/, uint32 /*COD*/, Item* /*item*/) { return true; }
+    virtual bool OnPlayerCanPlaceAuctionBid(Player* /*player*/, AuctionEntry* /*auction*/) { return true; }
+};
+
+class WorldScript
+{
+public:
+    explicit WorldScript(char const* /*name*/) { RegisteredWorldScripts().push_back(this); }
+    virtual ~WorldScript() = default;
+
+    virtual void OnBeforeConfigLoad(bool /*reload*/) { }
+    virtual void OnAfterConfigLoad(bool /*reload*/) { }
+    virtual void OnStartup() { }
+    virtual void OnShutdown() { }
+    virtual void OnUpdate(uint32 /*diff*/) { }
+};
+
+class GameObjectAI
+{
+public:
+    explicit GameObjectAI(GameObject* object) : me(object) { }
+    virtual ~GameObjectAI() = default;
+    virtual bool CanBeSeen(Player const* /*seer*/) { return true; }
+
+protected:
+    GameObject* me;
+};
+
+class GameObjectScript
+{
+public:
+    explicit GameObjectScript(char const* /*name*/) { }
+    virtual ~GameObjectScript() = default;
+    virtual bool OnGossipHello(Player* /*player*/, GameObject* /*object*/) { return false; }
+    virtual bool OnGossipSelect(Player* /*player*/, GameObject* /*object*/, uint32 /*sender*/, uint32 /*action*/) { return false; }
+    virtual GameObjectAI* GetAI(GameObject* /*object*/) const { return nullptr; }
+};
+
+class CommandScript
+{
+public:
+    explicit CommandScript(char const* /*name*/) { }
+    virtual ~CommandScript() = default;
+    virtual Acore::ChatCommands::ChatCommandTable GetCommands() const = 0;
+};
+
+enum Opcodes : uint16
+{
+    CMSG_AUCTION_SELL_ITEM = 0x256
+};
+
+class WorldPacket
+{
+public:
+    explicit WorldPacket(uint16 opcode) : _opcode(opcode) { }
+    [[nodiscard]] uint16 GetOpcode() const { return _opcode; }
+
+private:
+    uint16 _opcode;
+};
+
+class ServerScript
+{
+public:
+    explicit ServerScript(char const* /*name*/) { }
+    virtual ~ServerScript() = default;
+    virtual bool CanPacketReceive(WorldSession* /*session*/, WorldPacket const& /*packet*/) { return true; }
+};
+
+class MailScript
+{
+public:
+    explicit MailScript(char const* /*name*/) { }
+    virtual ~MailScript() = default;
+    virtual void OnBeforeMailDraftSendMailTo(MailDraft* /*mailDraft*/, MailReceiver const& /*receiver*/, MailSender const& /*sender*/, MailCheckMask& /*checked*/,
+        uint32& /*deliverDelay*/, uint32& /*customExpiration*/, bool& /*deleteMailItemsFromDB*/, bool& /*sendMail*/) { }
+};
+
+#endif //AZEROTHCORE_CHALLENGEMODES_CORE_STUB_H